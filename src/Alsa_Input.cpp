@@ -0,0 +1,251 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Alsa_Input.hpp"
+#include "Trace.hpp"
+#include "Realtime.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// hardware periods in the capture ring
+static const snd_pcm_uframes_t PERIODS = 4;
+// wait for a suspended device to resume up to RESUME_TRIES * RESUME_WAIT ms
+static const int RESUME_TRIES = 100;
+static const int RESUME_WAIT = 10;
+
+Alsa_Input::~Alsa_Input(){
+	stop_stream();
+}
+
+void Alsa_Input::start_stream(const Module_Config::Input& input_config){
+	stop_stream();
+
+	const std::string device = input_config.device.empty() ? "default" : input_config.device;
+	int err = snd_pcm_open(&pcm, device.c_str(), SND_PCM_STREAM_CAPTURE, SND_PCM_NONBLOCK);
+	if(err < 0){
+		pcm = nullptr;
+		throw std::runtime_error("Can't open ALSA device " + device + ": " + snd_strerror(err));
+	}
+
+	wakeup.reset();
+	try{
+		configure(input_config);
+
+		// the pcm descriptors are followed by the stop event
+		int count = snd_pcm_poll_descriptors_count(pcm);
+		if(count <= 0) throw std::runtime_error("ALSA device " + device + " has no poll descriptors!");
+		fds.resize(count + 1);
+		snd_pcm_poll_descriptors(pcm, fds.data(), count);
+
+		stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if(stop_fd < 0) throw std::runtime_error("Can't create ALSA eventfd: " + std::string(std::strerror(errno)));
+		fds[count] = {stop_fd, POLLIN, 0};
+
+		if((err = snd_pcm_prepare(pcm)) < 0 || (err = snd_pcm_start(pcm)) < 0){
+			throw std::runtime_error("Can't start ALSA capture: " + std::string(snd_strerror(err)));
+		}
+	}catch(std::runtime_error&){
+		stop_stream();
+		throw;
+	}
+
+	Module_Config::Thread sched = input_config.thread;
+	thread = std::thread([this, sched]{
+		TRACE_THREAD("alsa");
+		Realtime::apply(sched, "alsa");
+		run();
+	});
+}
+
+void Alsa_Input::stop_stream(){
+	if(thread.joinable()){
+		// wake up the reader
+		uint64_t one = 1;
+		if(write(stop_fd, &one, sizeof(one)) < 0){
+			std::cerr << "Can't stop the ALSA input!" << std::endl;
+		}
+		thread.join();
+	}
+
+	if(stop_fd >= 0){
+		close(stop_fd);
+		stop_fd = -1;
+	}
+	if(pcm){
+		snd_pcm_close(pcm);
+		pcm = nullptr;
+	}
+	fds.clear();
+}
+
+void Alsa_Input::report(std::ostream& os) const{
+	wakeup.report(os, "alsa");
+}
+
+void Alsa_Input::configure(const Module_Config::Input& input_config){
+	channels = input_config.stereo ? 2 : 1;
+	f_sample = input_config.f_sample;
+	period = input_config.period;
+	snd_pcm_uframes_t buffer_size = period * PERIODS;
+
+	snd_pcm_hw_params_t* hw;
+	snd_pcm_hw_params_malloc(&hw);
+	int err;
+	const char* step = "";
+	if((err = snd_pcm_hw_params_any(pcm, hw)) < 0){
+		step = "no configurations available";
+	}else if((err = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0){
+		step = "mmap access isn't supported, try a plug: device";
+	}else if((err = snd_pcm_hw_params_set_format(pcm, hw, SND_PCM_FORMAT_S16_LE)) < 0){
+		step = "S16_LE isn't supported";
+	}else if((err = snd_pcm_hw_params_set_channels(pcm, hw, channels)) < 0){
+		step = "channel count isn't supported";
+	}else if((err = snd_pcm_hw_params_set_rate_near(pcm, hw, &f_sample, nullptr)) < 0){
+		step = "sample rate isn't supported";
+	}else if((err = snd_pcm_hw_params_set_period_size_near(pcm, hw, &period, nullptr)) < 0){
+		step = "period size isn't supported";
+	}else if((err = snd_pcm_hw_params_set_buffer_size_near(pcm, hw, &buffer_size)) < 0){
+		step = "buffer size isn't supported";
+	}else if((err = snd_pcm_hw_params(pcm, hw)) < 0){
+		step = "can't apply the hardware parameters";
+	}
+	snd_pcm_hw_params_free(hw);
+	if(err < 0) throw std::runtime_error("ALSA configuration failed, " + std::string(step) + ": " + snd_strerror(err));
+
+	if(f_sample != input_config.f_sample){
+		std::cerr << "ALSA sample rate " << f_sample << "Hz doesn't match f_sample " << input_config.f_sample << "Hz!" << std::endl;
+	}
+
+	// wake up once per period
+	snd_pcm_sw_params_t* sw;
+	snd_pcm_sw_params_malloc(&sw);
+	if((err = snd_pcm_sw_params_current(pcm, sw)) >= 0 &&
+	   (err = snd_pcm_sw_params_set_avail_min(pcm, sw, period)) >= 0){
+		err = snd_pcm_sw_params(pcm, sw);
+	}
+	snd_pcm_sw_params_free(sw);
+	if(err < 0) throw std::runtime_error("Can't apply the ALSA software parameters: " + std::string(snd_strerror(err)));
+}
+
+void Alsa_Input::run(){
+	const unsigned count = fds.size() - 1;
+	while(true){
+		if(poll(fds.data(), fds.size(), -1) < 0){
+			if(errno == EINTR) continue;
+			std::cerr << "ALSA poll failed: " << std::strerror(errno) << std::endl;
+			break;
+		}
+		if(fds[count].revents) return;
+
+		unsigned short revents = 0;
+		int err = snd_pcm_poll_descriptors_revents(pcm, fds.data(), count, &revents);
+		if(err < 0 && !recover(err)) break;
+		if(revents & POLLERR){
+			if(!recover(-EPIPE)) break;
+		}else if(revents & POLLIN){
+			if(!read()) break;
+		}
+	}
+	std::cerr << "ALSA input stopped!" << std::endl;
+}
+
+// ingest everything available from the hardware ring, returns false on unrecoverable errors
+bool Alsa_Input::read(){
+	TRACE_SCOPE("Alsa_Input::read");
+	snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+	if(avail < 0) return recover(avail);
+	if(avail == 0) return true;
+	if(static_cast<snd_pcm_uframes_t>(avail) >= period){
+		wakeup.add(static_cast<float>(avail - period) / f_sample);
+	}
+
+	// the last available frame was captured delay - avail frames ago
+	snd_pcm_sframes_t delay = avail;
+	snd_pcm_delay(pcm, &delay);
+	auto t_capture = Buffers::clock::now() - std::chrono::microseconds((delay - avail) * 1000000 / f_sample);
+
+	std::unique_lock<std::mutex> lock(buffers->mut, std::defer_lock);
+	{
+		TRACE_SCOPE("lock Buffers::mut");
+		lock.lock();
+	}
+	while(avail > 0){
+		// the available frames may wrap around the end of the ring
+		const snd_pcm_channel_area_t* areas;
+		snd_pcm_uframes_t offset, frames = avail;
+		int err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+		if(err < 0) return recover(err);
+
+		auto* samples = reinterpret_cast<int16_t*>(static_cast<char*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8);
+		buffers->ingest(samples, frames * channels, t_capture);
+
+		snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm, offset, frames);
+		if(committed < 0 || static_cast<snd_pcm_uframes_t>(committed) != frames){
+			return recover(committed < 0 ? committed : -EPIPE);
+		}
+		avail -= frames;
+	}
+	return true;
+}
+
+// restart the capture depending on the state of the pcm, returns false on unrecoverable errors
+bool Alsa_Input::recover(const int error){
+	const snd_pcm_state_t state = snd_pcm_state(pcm);
+	int err = 0;
+	switch(state){
+	case SND_PCM_STATE_XRUN:
+		// the frames captured during the overrun are lost
+		buffers->overruns++;
+		err = snd_pcm_prepare(pcm);
+		break;
+	case SND_PCM_STATE_SUSPENDED:
+		// wait until the hardware resumed, restart the capture if it can't resume
+		for(int tries = 0; tries < RESUME_TRIES && (err = snd_pcm_resume(pcm)) == -EAGAIN; tries++){
+			// a stop request is handled by run
+			if(poll(&fds.back(), 1, RESUME_WAIT) > 0) return true;
+		}
+		if(err < 0) err = snd_pcm_prepare(pcm);
+		break;
+	case SND_PCM_STATE_PREPARED:
+	case SND_PCM_STATE_RUNNING:
+		// interrupted calls are retried, anything else doesn't go away by restarting
+		if(error != -EAGAIN && error != -EINTR && error != -EPIPE && error != -ESTRPIPE){
+			err = error;
+		}
+		break;
+	default:
+		// e.g. the device was disconnected
+		err = error;
+		break;
+	}
+	if(err >= 0 && snd_pcm_state(pcm) != SND_PCM_STATE_RUNNING){
+		err = snd_pcm_start(pcm);
+	}
+	if(err < 0){
+		std::cerr << "ALSA capture failed in state " << snd_pcm_state_name(state) << ": " << snd_strerror(err) << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Input.hpp"
+#include "Realtime.hpp"
+#include <alsa/asoundlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// captures directly from an ALSA device, the samples are ingested from the mmap'ed ring of the pcm
+class Alsa_Input : public Input{
+public:
+	explicit Alsa_Input(Buffers::Ptr& buffers) : buffers(buffers){};
+
+	~Alsa_Input() override;
+
+	void start_stream(const Module_Config::Input&) override;
+
+	void stop_stream() override;
+
+	void report(std::ostream&) const override;
+
+private:
+	Buffers::Ptr buffers;
+
+	snd_pcm_t* pcm = nullptr;
+	unsigned f_sample = 44100;
+	unsigned channels = 1;
+	snd_pcm_uframes_t period = 0;
+	// frames captured beyond avail_min when the reader runs
+	Realtime::Wakeup_Stats wakeup;
+
+	int stop_fd = -1;
+	std::vector<pollfd> fds;
+	std::thread thread;
+
+	void configure(const Module_Config::Input&);
+	void run();
+	bool read();
+	bool recover(const int);
+};
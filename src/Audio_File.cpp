@@ -0,0 +1,143 @@
+/*
+ *	Copyright (C) 2016  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Audio_File.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+void Audio_File::start_stream(const Module_Config::Input& input_config){
+	stop_stream();
+
+	file.open(input_config.file, std::ifstream::in | std::ifstream::binary);
+	if(!file.is_open()) throw std::runtime_error("Unable to open audio file: " + input_config.file + " !");
+
+	read_header(input_config);
+}
+
+void Audio_File::stop_stream(){
+	file.close();
+	file.clear();
+	frame = 0;
+	position = 0;
+	remaining = 0;
+}
+
+template<typename T>
+static inline T read_le(std::istream& is){
+	T value = 0;
+	is.read(reinterpret_cast<char*>(&value), sizeof(T));
+	return value;
+}
+
+void Audio_File::read_header(const Module_Config::Input& input_config){
+	// raw PCM uses the input configuration
+	channels = input_config.stereo ? 2 : 1;
+	f_sample = input_config.f_sample;
+	remaining = std::numeric_limits<unsigned long long>::max();
+
+	char riff[4], wave[4];
+	file.read(riff, 4);
+	read_le<uint32_t>(file);
+	file.read(wave, 4);
+	if(!file || std::strncmp(riff, "RIFF", 4) != 0 || std::strncmp(wave, "WAVE", 4) != 0){
+		file.clear();
+		file.seekg(0);
+		return;
+	}
+
+	// find the format and data chunks
+	while(file){
+		char id[4];
+		file.read(id, 4);
+		uint32_t length = read_le<uint32_t>(file);
+		if(!file) break;
+
+		if(std::strncmp(id, "data", 4) == 0){
+			// streamed WAVs don't know their length and read until the end of the file
+			if(length != 0xFFFFFFFF) remaining = length;
+			if(f_sample != input_config.f_sample){
+				std::cerr << "WAV sample rate " << f_sample << "Hz doesn't match f_sample " << input_config.f_sample << "Hz!" << std::endl;
+			}
+			return;
+		}
+
+		std::streamoff skip = length + (length & 1);
+		if(std::strncmp(id, "fmt ", 4) == 0 && length >= 16){
+			uint16_t format = read_le<uint16_t>(file);
+			channels = read_le<uint16_t>(file);
+			f_sample = read_le<uint32_t>(file);
+			read_le<uint32_t>(file); // byte rate
+			read_le<uint16_t>(file); // block align
+			uint16_t bits = read_le<uint16_t>(file);
+
+			// accept PCM and WAVE_FORMAT_EXTENSIBLE
+			if((format != 1 && format != 0xFFFE) || bits != 16 || channels == 0){
+				throw std::runtime_error("Unsupported WAV format, only 16 bit PCM is supported!");
+			}
+			skip -= 16;
+		}
+		file.seekg(skip, std::ios_base::cur);
+	}
+	throw std::runtime_error("WAV file has no data chunk!");
+}
+
+bool Audio_File::read_frame(const int fps){
+	// distribute the samples evenly if f_sample isn't a multiple of fps
+	frame++;
+	// like the frame scheduler, a frame rate below 1 renders 1 fps
+	unsigned long long target = frame * f_sample / std::max(fps, 1);
+	size_t n = target - position;
+	position = target;
+
+	const size_t frame_size = sizeof(int16_t) * channels;
+	n = std::min<unsigned long long>(n, remaining / frame_size);
+
+	pre_buffer.resize(n * channels);
+	file.read(reinterpret_cast<char*>(pre_buffer.data()), pre_buffer.size() * sizeof(int16_t));
+	remaining -= file.gcount();
+	size_t n_read = file.gcount() / frame_size;
+	if(n_read == 0) return false;
+
+	std::lock_guard<std::mutex> lock(buffers->mut);
+	std::vector<Buffer<int16_t>>& bufs = buffers->bufs;
+	if(channels == 1){
+		for(Buffer<int16_t>& buf : bufs){
+			buf.write(pre_buffer.data(), n_read);
+		}
+	}else if(bufs.size() > 1){
+		bufs[0].write_offset(pre_buffer.data(), n_read * channels, channels, 0);
+		bufs[1].write_offset(pre_buffer.data(), n_read * channels, channels, 1);
+	}else{
+		// downmix into a single buffer
+		mix_buffer.resize(n_read);
+		for(size_t i = 0; i < n_read; i++){
+			int sum = 0;
+			for(unsigned c = 0; c < channels; c++){
+				sum += pre_buffer[i * channels + c];
+			}
+			mix_buffer[i] = sum / static_cast<int>(channels);
+		}
+		bufs[0].write(mix_buffer.data(), n_read);
+	}
+	return true;
+}
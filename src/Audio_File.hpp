@@ -0,0 +1,53 @@
+/*
+ *	Copyright (C) 2016  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Input.hpp"
+#include <fstream>
+#include <vector>
+
+// offline input, reads 16 bit WAV or raw PCM files frame by frame
+class Audio_File : public Input{
+public:
+	explicit Audio_File(Buffers::Ptr& buffers) : buffers(buffers){};
+
+	void start_stream(const Module_Config::Input&) override;
+
+	void stop_stream() override;
+
+	bool is_offline() const override { return true; };
+
+	bool read_frame(const int fps) override;
+
+private:
+	Buffers::Ptr buffers;
+	std::ifstream file;
+
+	unsigned channels = 1;
+	long long f_sample = 44100;
+	// number of read frames and samples per channel
+	unsigned long long frame = 0, position = 0;
+	// bytes left in the data chunk, trailing chunks aren't audio
+	unsigned long long remaining = 0;
+
+	std::vector<int16_t> pre_buffer, mix_buffer;
+
+	void read_header(const Module_Config::Input&);
+};
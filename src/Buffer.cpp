@@ -18,8 +18,10 @@
  */
 
 #include "Buffer.hpp"
+#include "Trace.hpp"
 #include <type_traits>
 #include <algorithm>
+#include <array>
 
 template<typename T>
 Buffer<T>::Buffer(const size_t size){
@@ -28,10 +30,13 @@ Buffer<T>::Buffer(const size_t size){
 	v_buffer.resize(size);
 	this->size = size;
 	new_data = true;
+	seq = 0;
+	silent = size;
 }
 
 template<typename T>
 std::unique_lock<std::mutex> Buffer<T>::lock(){
+	TRACE_SCOPE("Buffer::lock");
 	return std::unique_lock<std::mutex>(m);
 }
 
@@ -42,6 +47,43 @@ static inline T ceil_div(const T x, const T y){
 }
 
 
+// check if the samples only contain digital silence
+template<typename T>
+static inline bool is_silent(const T buf[], const size_t n){
+	return std::all_of(buf, buf + n, [](const T x){ return x == 0; });
+}
+
+// track trailing silence, returns false if the buffer content doesn't change
+template<typename T>
+inline bool Buffer<T>::update_silence(const T buf[], const size_t n){
+	bool block_silent = is_silent(buf, n);
+	bool unchanged = block_silent && silent >= size;
+
+	silent = block_silent ? std::min(silent + n, size) : 0;
+	return !unchanged;
+}
+
+// count the samples of a write of n samples of which length fit into the buffer
+template<typename T>
+inline void Buffer<T>::account(const size_t n, const size_t length){
+	stats.received += n;
+	stats.truncated += n - length;
+}
+
+// appending length samples shifts out the oldest samples that haven't been analysed yet
+template<typename T>
+inline void Buffer<T>::shift_pending(const size_t length){
+	size_t lost = pending + length > size ? pending + length - size : 0;
+	stats.overwritten += std::min(lost, pending);
+	pending = std::min(pending + length, size);
+}
+
+template<typename T>
+void Buffer<T>::consume(){
+	new_data = false;
+	pending = 0;
+}
+
 template<typename T>
 inline void Buffer<T>::i_write(T buf[], const size_t n){
 	// move old data
@@ -59,33 +101,48 @@ inline void Buffer<T>::i_write(const std::vector<T>& buf, const size_t n){
 }
 
 template<typename T>
-void Buffer<T>::write(T buf[], const size_t n){
+bool Buffer<T>::write(T buf[], const size_t n, const clock::time_point t){
 	auto lock = this->lock();
-	new_data = true;
 
 	// limit data to write
 	size_t length = std::min(n, size);
+	account(n, length);
+	if(!update_silence(buf, length)) return false;
+
+	new_data = true;
+	seq++;
+	t_capture = t;
+	shift_pending(length);
 	i_write(buf, length);
+	return true;
 }
 
 template<typename T>
-void Buffer<T>::write(const std::vector<T>& buf){
+bool Buffer<T>::write(const std::vector<T>& buf, const clock::time_point t){
 	auto lock = this->lock();
-	new_data = true;
 
 	// limit data to write
 	size_t length = std::min(buf.size(), size);
+	account(buf.size(), length);
+	if(!update_silence(buf.data(), length)) return false;
+
+	new_data = true;
+	seq++;
+	t_capture = t;
+	shift_pending(length);
 	i_write(buf, length);
+	return true;
 }
 
 template<typename T>
-void Buffer<T>::write_offset(T buf[], const size_t n, const size_t gap, const size_t offset){
+bool Buffer<T>::write_offset(T buf[], const size_t n, const size_t gap, const size_t offset, const clock::time_point t){
 	auto lock = this->lock();
-	new_data = true;
 
 	// limit data to write
-	size_t length = std::min(ceil_div(n - offset, gap), size);
+	size_t count = ceil_div(n - offset, gap);
+	size_t length = std::min(count, size);
 	size_t current = offset;
+	account(count, length);
 
 	// resize intermediate buffer
 	if(ibuf.size() < length) ibuf.resize(length);
@@ -93,17 +150,25 @@ void Buffer<T>::write_offset(T buf[], const size_t n, const size_t gap, const si
 		ibuf[i] = buf[current];
 		current += gap;
 	}
+	if(!update_silence(ibuf.data(), length)) return false;
+
+	new_data = true;
+	seq++;
+	t_capture = t;
+	shift_pending(length);
 	i_write(ibuf, length);
+	return true;
 }
 
 template<typename T>
-void Buffer<T>::write_offset(const std::vector<T>& buf, const size_t gap, const size_t offset){
+bool Buffer<T>::write_offset(const std::vector<T>& buf, const size_t gap, const size_t offset, const clock::time_point t){
 	auto lock = this->lock();
-	new_data = true;
 
 	// limit data to write
-	size_t length = std::min(ceil_div(buf.size() - offset, gap), size);
+	size_t count = ceil_div(buf.size() - offset, gap);
+	size_t length = std::min(count, size);
 	size_t current = offset;
+	account(count, length);
 
 	// resize intermediate buffer
 	if(ibuf.size() < length) ibuf.resize(length);
@@ -111,7 +176,14 @@ void Buffer<T>::write_offset(const std::vector<T>& buf, const size_t gap, const
 		ibuf[i] = buf[current];
 		current += gap;
 	}
+	if(!update_silence(ibuf.data(), length)) return false;
+
+	new_data = true;
+	seq++;
+	t_capture = t;
+	shift_pending(length);
 	i_write(ibuf, length);
+	return true;
 }
 
 template<typename T>
@@ -121,6 +193,10 @@ void Buffer<T>::resize(const size_t n){
 		size = n;
 		v_buffer.resize(n);
 		new_data = true;
+		seq++;
+		// resizing may add silence
+		silent = is_silent(v_buffer.data(), size) ? size : 0;
+		pending = std::min(pending, size);
 	}
 }
 
@@ -23,41 +23,89 @@
 #include <cstdint>
 #include <mutex>
 #include <memory>
+#include <chrono>
+#include <atomic>
+#include <functional>
 
 template<typename T>
 class Buffer {
 	public:
+		using clock = std::chrono::steady_clock;
+
+		// sample accounting, guarded by lock()
+		struct Stats {
+			uint64_t received = 0; // samples passed to write
+			uint64_t truncated = 0; // samples of writes larger than the buffer
+			uint64_t overwritten = 0; // samples shifted out before they have been analysed
+		};
+
 		Buffer(const size_t);
 		Buffer(const Buffer& b) = delete;
-		Buffer(Buffer&& b): v_buffer(std::move(b.v_buffer)), size(std::move(b.size)){};
+		Buffer(Buffer&& b): v_buffer(std::move(b.v_buffer)), new_data(b.new_data), seq(b.seq), t_capture(b.t_capture), stats(b.stats), size(std::move(b.size)), silent(b.silent), pending(b.pending){};
 		//Buffer& operator=(Buffer&& b){ v_buffer = std::move(b.v_buffer); size = std::move(b.size);  return *this; };
 
 		std::vector<T> v_buffer;
 		bool new_data;
+		uint64_t seq; // incremented every time the buffer content changes
+		clock::time_point t_capture; // capture time of the newest sample
+		Stats stats;
 		size_t size;
 
 		std::unique_lock<std::mutex> lock();
-		void write(T buf[], const size_t);
-		void write(const std::vector<T>& buf);
-		void write_offset(T buf[], const size_t, const size_t, const size_t);
-		void write_offset(const std::vector<T>& buf, const size_t, const size_t);
+		// the capture time defaults to the time of the write
+		// returns false if the content didn't change, i.e. silence was written into a silent buffer
+		bool write(T buf[], const size_t, const clock::time_point = clock::now());
+		bool write(const std::vector<T>& buf, const clock::time_point = clock::now());
+		bool write_offset(T buf[], const size_t, const size_t, const size_t, const clock::time_point = clock::now());
+		bool write_offset(const std::vector<T>& buf, const size_t, const size_t, const clock::time_point = clock::now());
 		void resize(const size_t);
 		float rms();
+		// mark the content as analysed and clear new_data, has to be called with the lock held
+		void consume();
 
 	private:
 		std::mutex m;
+		size_t silent; // number of trailing silent samples
+		size_t pending = 0; // samples written since the last consume
 
 		std::vector<T> ibuf; // intermediate buffer for interleaved writes
+		bool update_silence(const T buf[], const size_t);
+		void account(const size_t, const size_t);
+		void shift_pending(const size_t);
 		void i_write(T buf[], const size_t);
 		void i_write(const std::vector<T>&, const size_t);
 };
 
 struct Buffers{
 	using Ptr = std::shared_ptr<Buffers>;
+	using clock = Buffer<int16_t>::clock;
+	// receives every ingested block, e.g. for recording
+	using Tap = std::function<void(const int16_t[], const size_t, const clock::time_point)>;
+	// called from the input thread after the buffer content has changed, e.g. to wake up the render thread
+	using Notify = std::function<void()>;
+
 	std::vector<Buffer<int16_t>> bufs;
 	std::mutex mut;
+	// blocks dropped by the input before they reached the buffers
+	std::atomic<uint64_t> overruns;
+	Tap tap;
+	Notify notify;
+
+	Buffers():bufs(), mut(), overruns(0){};
+
+	// write n interleaved samples captured at t into the channel buffers, has to be called with mut locked
+	inline void ingest(int16_t buf[], const size_t n, const clock::time_point t){
+		if(tap) tap(buf, n, t);
 
-	Buffers():bufs(), mut(){};
+		bool changed;
+		if(bufs.size() > 1){
+			changed = bufs[0].write_offset(buf, n, 2, 0, t);
+			changed |= bufs[1].write_offset(buf, n, 2, 1, t);
+		}else{
+			changed = bufs[0].write(buf, n, t);
+		}
+		if(changed && notify) notify();
+	}
 };
 
 template class Buffer<int16_t>;
@@ -20,6 +20,8 @@
 #include "Config.hpp"
 
 #include "xdg.hpp"
+#include "Trace.hpp"
+#include "Decimator.hpp"
 #include <stdlib.h>
 #include <iostream>
 #include <algorithm>
@@ -43,29 +45,47 @@ Config::Config(const std::string& config_file){
 	if(file == "") file = "/etc/GLMViz/config";
 
 	reload();
-	old_input = input;
 }
 
 void Config::reload(){
+	TRACE_SCOPE("Config::reload");
+	libconfig::Config cfg;
 	try{
 		cfg.readFile(file.c_str());
 
 		cfg.lookupValue("Window.AA", w_aa);
 		cfg.lookupValue("Window.height", w_height);
 		cfg.lookupValue("Window.width", w_width);
+		cfg.lookupValue("Window.analytic_AA", analytic_aa);
 
-		old_input = input;
 		try{
 			parse_input(input, cfg.lookup("Input"));
 		}catch(const libconfig::SettingNotFoundException& e){}
 
+		try{
+			parse_output(output, cfg.lookup("Output"));
+		}catch(const libconfig::SettingNotFoundException& e){}
+
+		try{
+			parse_thread(input.thread, cfg.lookup("Threads.input"));
+		}catch(const libconfig::SettingNotFoundException& e){}
+		try{
+			parse_thread(render_thread, cfg.lookup("Threads.render"));
+		}catch(const libconfig::SettingNotFoundException& e){}
+
 		cfg.lookupValue("duration", duration);
 		cfg.lookupValue("fps", fps);
+		cfg.lookupValue("skip_idle_frames", skip_idle_frames);
+		cfg.lookupValue("low_latency", low_latency);
 
 		cfg.lookupValue("show_fps", show_fps);
 		cfg.lookupValue("show_fps_interval", show_fps_interval);
+		cfg.lookupValue("show_gpu_time", show_gpu_time);
+		cfg.lookupValue("trace_file", trace_file);
+		cfg.lookupValue("stats_file", stats_file);
 
 		cfg.lookupValue("fft_size", fft.size);
+		cfg.lookupValue("decimate", decimate);
 		buf_size = Util::buffer_size(input.f_sample, static_cast<float>(duration) / 1000);
 		fft.output_size = fft.size/2+1;
 		fft.d_freq = Util::fft_df<float>(input.f_sample, fft.size);
@@ -82,63 +102,23 @@ void Config::reload(){
 		}
 		catch(const libconfig::SettingNotFoundException& e){}
 
-		for(unsigned i = 0; i < MAX_OSCILLOSCOPES; i++){
-			std::string path = "Osc" + std::to_string(i+1);
-			try{
-				// init new Oscilloscope with default parameters
-				Module_Config::Oscilloscope tmp = osc_default;
-				// parse Oscilloscope and add it to the list
-				parse_oscilloscope(tmp, cfg.lookup(path));
-
-				try{
-					// reuse old values if possible
-					oscilloscopes.at(i) = tmp;
-				}
-				catch(std::out_of_range& e){
-					oscilloscopes.push_back(tmp);
-				}
-			}
-			catch(const libconfig::SettingNotFoundException& e){
-				// delete remaining oscilloscopes
-				if(oscilloscopes.size() > i){
-					oscilloscopes.erase(oscilloscopes.begin() + i, oscilloscopes.end());
-				}
-				break;
-			}
-		}
-
 		try{
 			parse_spectrum(spec_default, cfg.lookup("Spectrum"), fft);
 		}
 		catch(const libconfig::SettingNotFoundException& e){}
 
-		for(unsigned i = 0; i < MAX_SPECTRA; i++){
-			std::string path = "Spectrum" + std::to_string(i+1);
-			try{
-				// init new Spectrum with default parameters
-				Module_Config::Spectrum tmp = spec_default;
-				// parse Spectrum and add it to the list
-				parse_spectrum(tmp, cfg.lookup(path), fft);
-
-				// reuse old values if possible
-				try{
-					spectra.at(i) = tmp;
-				}
-				catch(std::out_of_range& e){
-					spectra.push_back(tmp);
-				}
-			}
-			catch(const libconfig::SettingNotFoundException& e){
-				// delete remaining spectra
-				if(spectra.size() > i){
-					spectra.erase(spectra.begin() + i, spectra.end());
-				}
-				break;
-			}
+		// modules are numbered from 1 without gaps, followed by the entries of the Modules list
+		oscilloscopes.clear();
+		for(unsigned i = 1; cfg.exists("Osc" + std::to_string(i)); i++){
+			add_oscilloscope(cfg.lookup("Osc" + std::to_string(i)));
+		}
+		spectra.clear();
+		for(unsigned i = 1; cfg.exists("Spectrum" + std::to_string(i)); i++){
+			add_spectrum(cfg.lookup("Spectrum" + std::to_string(i)));
+		}
+		if(cfg.exists("Modules")){
+			parse_modules(cfg.lookup("Modules"));
 		}
-
-		//std::cout << oscilloscopes.size() << std::endl;
-		//std::cout << spectra.size() << std::endl;
 
 	}catch(const libconfig::FileIOException &fioex){
 		std::cerr << "I/O error while reading file." << std::endl;
@@ -155,6 +135,70 @@ void Config::reload(){
 	if(spectra.size() == 0 && oscilloscopes.size() == 0){
 		spectra.push_back(spec_default);
 	}
+
+	assign_decimation();
+}
+
+// parsers of the module types in the Modules list
+const std::map<std::string, Config::Module_Parser> Config::module_types = {
+	{"spectrum", &Config::add_spectrum},
+	{"oscilloscope", &Config::add_oscilloscope},
+	{"osc", &Config::add_oscilloscope}
+};
+
+void Config::parse_modules(libconfig::Setting& modules){
+	for(int i = 0; i < modules.getLength(); i++){
+		libconfig::Setting& m = modules[i];
+		std::string type;
+		m.lookupValue("type", type);
+		std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+
+		auto parser = module_types.find(type);
+		if(parser == module_types.end()){
+			std::cerr << "Unknown module type \"" << type << "\" in " << m.getPath() << std::endl;
+			continue;
+		}
+		(this->*(parser->second))(m);
+	}
+}
+
+// new modules start with the default parameters
+void Config::add_spectrum(libconfig::Setting& cfg){
+	Module_Config::Spectrum s = spec_default;
+	parse_spectrum(s, cfg, fft);
+	spectra.push_back(s);
+}
+
+void Config::add_oscilloscope(libconfig::Setting& cfg){
+	Module_Config::Oscilloscope o = osc_default;
+	parse_oscilloscope(o, cfg);
+	oscilloscopes.push_back(o);
+}
+
+// select the decimated stream of each spectrum, spectra of the same channel and factor share it
+void Config::assign_decimation(){
+	decimation.clear();
+	for(Module_Config::Spectrum& s : spectra){
+		s.stream = -1;
+		if(!decimate) continue;
+
+		float f_stop = (s.data_offset + s.output_size) * fft.d_freq;
+		unsigned factor = Decimator::factor_for(f_stop, input.f_sample, fft.size, buf_size);
+		if(factor == 1) continue;
+
+		Module_Config::Decimation d;
+		d.channel = input.stereo ? s.channel : 0;
+		d.factor = factor;
+		auto it = std::find_if(decimation.begin(), decimation.end(), [&](const Module_Config::Decimation& e){
+			return e.channel == d.channel && e.factor == d.factor;
+		});
+		s.stream = it - decimation.begin();
+		if(it == decimation.end()) decimation.push_back(d);
+
+		// the decimated fft has a factor times smaller input
+		float isize = std::min(buf_size / factor, fft.size / factor)/2+1;
+		s.scale = Util::fft_scale(isize, 32768.0f);
+	}
 }
 
 void Config::parse_input(Module_Config::Input& i, libconfig::Setting& cfg){
@@ -164,6 +208,18 @@ void Config::parse_input(Module_Config::Input& i, libconfig::Setting& cfg){
 	std::transform(str_source.begin(), str_source.end(), str_source.begin(), ::tolower);
 	if(str_source == "pulse"){
 		i.source = Module_Config::Source::PULSE;
+	}else if(str_source == "file"){
+		i.source = Module_Config::Source::FILE;
+	}else if(str_source == "replay"){
+		i.source = Module_Config::Source::REPLAY;
+	}else if(str_source == "shm"){
+		i.source = Module_Config::Source::SHM;
+	}else if(str_source == "udp"){
+		i.source = Module_Config::Source::UDP;
+	}else if(str_source == "rtp"){
+		i.source = Module_Config::Source::RTP;
+	}else if(str_source == "alsa"){
+		i.source = Module_Config::Source::ALSA;
 	}else{
 		i.source = Module_Config::Source::FIFO;
 	}
@@ -172,6 +228,38 @@ void Config::parse_input(Module_Config::Input& i, libconfig::Setting& cfg){
 	cfg.lookupValue("device", i.device);
 	cfg.lookupValue("stereo", i.stereo);
 	cfg.lookupValue("f_sample", i.f_sample);
+	cfg.lookupValue("record", i.record);
+	cfg.lookupValue("realtime", i.realtime);
+	cfg.lookupValue("port", i.port);
+	cfg.lookupValue("period", i.period);
+	i.period = std::max(i.period, 16LL);
+
+	std::string encoding;
+	if(cfg.lookupValue("encoding", encoding)){
+		std::transform(encoding.begin(), encoding.end(), encoding.begin(), ::toupper);
+		i.l24 = encoding == "L24";
+	}
+}
+
+void Config::parse_output(Module_Config::Output& o, libconfig::Setting& cfg){
+	cfg.lookupValue("file", o.file);
+	cfg.lookupValue("frames", o.frames);
+}
+
+void Config::parse_thread(Module_Config::Thread& t, libconfig::Setting& cfg){
+	std::string policy;
+	if(cfg.lookupValue("policy", policy)){
+		std::transform(policy.begin(), policy.end(), policy.begin(), ::tolower);
+		if(policy == "fifo"){
+			t.policy = Module_Config::Thread::Policy::FIFO;
+		}else if(policy == "rr"){
+			t.policy = Module_Config::Thread::Policy::RR;
+		}else{
+			t.policy = Module_Config::Thread::Policy::OTHER;
+		}
+	}
+	cfg.lookupValue("priority", t.priority);
+	cfg.lookupValue("cpus", t.cpus);
 }
 
 void Config::parse_oscilloscope(Module_Config::Oscilloscope& o, libconfig::Setting& cfg){
@@ -20,32 +20,46 @@
 #pragma once
 
 #include <vector>
+#include <map>
+#include <string>
 #include <libconfig.h++>
 #include "Module_Config.hpp"
 
 class Config {
 	public:
 		Config(const std::string&);
-		// disable copy construction
-		Config(const Config&) = delete;
+		// parse the file again, settings missing in the file keep their current values
 		void reload();
 
 		int w_aa = 4;
 		int w_height = 768;
 		int w_width = 1024;
+		bool analytic_aa = false;
 
 		Module_Config::Input input;
-		Module_Config::Input old_input;
+		Module_Config::Output output;
+		// scheduling of the render thread, which also runs the analysis
+		Module_Config::Thread render_thread;
 
 		int duration = 50;
 		int fps = 60;
+		bool skip_idle_frames = true;
+		bool low_latency = false;
 
 		bool show_fps = false;
 		int show_fps_interval = 60;
+		bool show_gpu_time = false;
+		// chrome trace output, written on SIGUSR2 and on exit (trace builds only)
+		std::string trace_file = "/tmp/GLMViz.trace.json";
+		// input sample counters as json, rewritten every show_fps_interval frames, empty to disable
+		std::string stats_file;
 
 		long long buf_size = input.f_sample * duration / 1000;
 
 		Module_Config::FFT fft;
+		// analyse each spectrum at the lowest sample rate its frequency range allows
+		bool decimate = false;
+		std::vector<Module_Config::Decimation> decimation;
 
 		Module_Config::Color bg_color = {0, 0, 0, 1};
 
@@ -55,22 +69,33 @@ class Config {
 		std::vector<Module_Config::Oscilloscope> oscilloscopes;
 		std::vector<Module_Config::Spectrum> spectra;
 
-		std::string get_file(){
+		std::string get_file() const{
 			return file;
 		}
+
+		// offline inputs are rendered as fast as possible
+		bool offline() const{
+			return input.source == Module_Config::Source::FILE ||
+				(input.source == Module_Config::Source::REPLAY && !input.realtime);
+		}
 	private:
-		libconfig::Config cfg;
 		std::string file;
 
 		void parse_input(Module_Config::Input&, libconfig::Setting&);
+		void parse_output(Module_Config::Output&, libconfig::Setting&);
+		void parse_thread(Module_Config::Thread&, libconfig::Setting&);
 		void parse_fft(Module_Config::FFT&, libconfig::Setting&);
 		void parse_color(Module_Config::Color&, const std::string&, libconfig::Setting&);
 		void parse_rainbow(Module_Config::Spectrum&, libconfig::Setting&);
 		void parse_transformation(Module_Config::Transformation&, const std::string&, libconfig::Setting&);
 		void parse_oscilloscope(Module_Config::Oscilloscope&, libconfig::Setting&);
 		void parse_spectrum(Module_Config::Spectrum&, libconfig::Setting&, const Module_Config::FFT&);
-
-
-		static const unsigned MAX_SPECTRA = 4;
-		static const unsigned MAX_OSCILLOSCOPES = 4;
+		void assign_decimation();
+
+		// module registry, maps the type of a Modules entry to the parser that adds it
+		using Module_Parser = void (Config::*)(libconfig::Setting&);
+		static const std::map<std::string, Module_Parser> module_types;
+		void parse_modules(libconfig::Setting&);
+		void add_spectrum(libconfig::Setting&);
+		void add_oscilloscope(libconfig::Setting&);
 };
@@ -0,0 +1,82 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Config_Loader.hpp"
+#include "Realtime.hpp"
+#include "Trace.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+Config_Loader::~Config_Loader(){
+	finish();
+}
+
+void Config_Loader::request(const Config& current){
+	// the running parse may have read the file before it changed
+	if(worker.joinable()){
+		requested = true;
+		return;
+	}
+	start(current);
+}
+
+void Config_Loader::start(const Config& current){
+	// the copy is made on the calling thread, the worker owns it exclusively
+	std::shared_ptr<Config> next = std::make_shared<Config>(current);
+	done = false;
+	worker = std::thread([this, next]{
+		TRACE_THREAD("config");
+		Realtime::reset("config");
+		try{
+			next->reload();
+			snapshot = next;
+		}catch(std::exception& e){
+			// keep the current config
+			std::cerr << "Can't reload the config: " << e.what() << std::endl;
+		}
+		done = true;
+	});
+}
+
+bool Config_Loader::poll(Config& config){
+	if(!worker.joinable() || !done) return false;
+	worker.join();
+
+	bool swapped = false;
+	if(snapshot){
+		old.reset(new Config(std::move(config)));
+		config = *snapshot;
+		snapshot.reset();
+		swapped = true;
+	}
+
+	if(requested){
+		requested = false;
+		start(config);
+	}
+	return swapped;
+}
+
+void Config_Loader::finish(){
+	if(worker.joinable()){
+		worker.join();
+	}
+}
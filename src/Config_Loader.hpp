@@ -0,0 +1,65 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "Config.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/*
+	Parses reloaded configs on a worker thread. The worker starts from a copy of the
+	current config, so settings missing in the file keep their values, and publishes
+	it as an immutable snapshot. The render thread swaps the snapshot in between two
+	frames and compares it to the previous config to reconfigure only what changed.
+*/
+class Config_Loader {
+	public:
+		Config_Loader() = default;
+		Config_Loader(const Config_Loader&) = delete;
+		~Config_Loader();
+
+		// start parsing the config file, never blocks
+		// during a reload in progress the file is parsed again once it finished
+		void request(const Config&);
+
+		// replace the config with the parsed snapshot, returns false if it isn't ready yet
+		// starts the next reload if another one has been requested in the meantime
+		bool poll(Config&);
+		// a reload has been requested and not swapped in yet
+		bool pending() const { return worker.joinable(); };
+
+		// the config replaced by the last successful poll
+		const Config& previous() const { return *old; };
+
+	private:
+		std::thread worker;
+		std::atomic<bool> done{false};
+		// the file changed again while it was parsed
+		bool requested = false;
+
+		// result of the worker, only accessed after done has been set
+		std::shared_ptr<const Config> snapshot;
+		std::unique_ptr<Config> old;
+
+		void start(const Config&);
+		void finish();
+};
@@ -17,42 +17,49 @@
  *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #include <iostream>
-#include <unistd.h>
 #include <stdexcept>
-#include <poll.h>
-#include "Inotify.hpp"
+#include <unistd.h>
 #include "Config_Monitor.hpp"
 
-static const int timeout = 100;
-void monitor(const std::string& file, std::atomic<bool>& running, std::atomic<bool>& changed){
-	try{
-		Inotify inotify;
-		int wd = inotify.add_watch(file, IN_MODIFY | IN_IGNORED);
-		int fd = inotify.get_fd();
-
-		while(running){
-			struct pollfd pfd;
-			pfd.fd = fd;
-			pfd.events = POLLIN;
-
-			int ret = poll(&pfd, 1, timeout);
-			if(ret > 0){
-				struct inotify_event e;
-				size_t n_read = read(fd, reinterpret_cast<char*>(&e), sizeof(struct inotify_event));
-				if(n_read && e.wd == wd){
-					// vim edit workaround
-					if(e.mask == IN_IGNORED){
-						// delete ignored watch descriptor
-						inotify.rm_watch(wd);
-						// make new watch descriptor on same file
-						wd = inotify.add_watch(file, IN_MODIFY | IN_IGNORED);
-					}
-					changed = true;
-				}
+Config_Monitor::Config_Monitor(const std::string& file, Event_Loop& loop, const std::function<void()>& changed):
+	file(file), loop(loop), changed(changed){
+	wd = inotify.add_watch(file, IN_MODIFY | IN_IGNORED);
+	loop.add(inotify.get_fd(), [this]{ read_events(); });
+}
+
+Config_Monitor::~Config_Monitor(){
+	loop.remove(inotify.get_fd());
+}
+
+void Config_Monitor::read_events(){
+	alignas(struct inotify_event) char buf[4096];
+	ssize_t n_read = read(inotify.get_fd(), buf, sizeof(buf));
+
+	bool modified = false;
+	for(ssize_t i = 0; i < n_read;){
+		const struct inotify_event* e = reinterpret_cast<const struct inotify_event*>(buf + i);
+		i += sizeof(struct inotify_event) + e->len;
+		if(e->wd != wd) continue;
+
+		// vim edit workaround
+		if(e->mask & IN_IGNORED){
+			// delete ignored watch descriptor
+			inotify.rm_watch(wd);
+			// make new watch descriptor on same file
+			try{
+				wd = inotify.add_watch(file, IN_MODIFY | IN_IGNORED);
+			}catch(std::runtime_error& err){
+				// the config is still reloaded with SIGUSR1
+				std::cerr << err.what() << std::endl;
+				loop.remove(inotify.get_fd());
 			}
 		}
-	}catch(std::runtime_error& e){
-		std::cerr << e.what() << std::endl;
+		modified = true;
+	}
+
+	if(modified){
+		changed();
 	}
 }
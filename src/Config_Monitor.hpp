@@ -17,9 +17,27 @@
  *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #pragma once
 
-#include <atomic>
+#include "Event_Loop.hpp"
+#include "Inotify.hpp"
+
+#include <functional>
 #include <string>
 
-void monitor(const std::string&, std::atomic<bool>&, std::atomic<bool>&);
+// watches the config file through the event loop and calls the handler after every modification
+class Config_Monitor{
+	public:
+		Config_Monitor(const std::string& file, Event_Loop&, const std::function<void()>& changed);
+		~Config_Monitor();
+
+	private:
+		std::string file;
+		Event_Loop& loop;
+		std::function<void()> changed;
+		Inotify inotify;
+		int wd;
+
+		void read_events();
+};
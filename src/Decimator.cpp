@@ -0,0 +1,124 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Decimator.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// fraction of the decimated sample rate that is analysed, the transition band ends at the mirrored passband edge
+static const float PASSBAND = 0.4;
+// filter length per decimation factor
+static const unsigned TAPS_PER_FACTOR = 32;
+// smallest decimated fft and buffer size
+static const size_t MIN_SIZE = 64;
+// Kaiser window shape, rejects aliases by more than 90 dB at this filter length
+static const double KAISER_BETA = 9;
+
+// modified Bessel function of the first kind and order zero
+static double bessel_i0(const double x){
+	double sum = 1, term = 1;
+	for(int k = 1; term > 1e-12 * sum; k++){
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+Decimator::Decimator(const unsigned factor, const size_t buf_size): factor(factor), buffer(buf_size / factor){
+	// windowed sinc with the cutoff at the decimated nyquist frequency,
+	// aliases fold into the transition band above the analysed range
+	const unsigned n = TAPS_PER_FACTOR * factor + 1;
+	const float fc = 0.5f / factor;
+	taps.resize(n);
+	float sum = 0;
+	for(unsigned i = 0; i < n; i++){
+		float x = static_cast<float>(i) - (n - 1) / 2.0f;
+		float sinc = x == 0 ? 2 * fc : std::sin(2 * M_PI * fc * x) / (M_PI * x);
+		// Kaiser window
+		double r = 2.0 * i / (n - 1) - 1;
+		float w = bessel_i0(KAISER_BETA * std::sqrt(std::max(0.0, 1 - r * r))) / bessel_i0(KAISER_BETA);
+		taps[i] = sinc * w;
+		sum += taps[i];
+	}
+	// unity gain at dc
+	for(float& t : taps) t /= sum;
+
+	reset();
+}
+
+void Decimator::reset(){
+	history.assign(taps.size() - 1, 0);
+	next = taps.size() - 1;
+}
+
+bool Decimator::update(Buffer<int16_t>& source){
+	TRACE_SCOPE("Decimator::update");
+	const size_t n_taps = taps.size();
+	Buffer<int16_t>::clock::time_point t_capture;
+	{
+		auto lock = source.lock();
+		uint64_t n = source.stats.received - received;
+		received = source.stats.received;
+		t_capture = source.t_capture;
+		if(n == 0) return false;
+
+		// the source only holds its newest samples, restart the filter after a gap
+		if(n > source.size){
+			reset();
+			n = source.size;
+		}
+		// digital silence isn't written, but the tail of a silent buffer is zero as well
+		history.insert(history.end(), source.v_buffer.end() - n, source.v_buffer.end());
+	}
+
+	// only every factor-th output is computed (polyphase decomposition of the filter)
+	output.clear();
+	const float* h = taps.data();
+	for(; next < history.size(); next += factor){
+		const float* x = history.data() + next + 1 - n_taps;
+		float acc = 0;
+		#pragma omp simd reduction(+:acc)
+		for(size_t k = 0; k < n_taps; k++){
+			acc += h[k] * x[k];
+		}
+		output.push_back(static_cast<int16_t>(std::max(-32768.f, std::min(32767.f, std::round(acc)))));
+	}
+
+	// keep the samples that are still needed for the next outputs
+	size_t drop = history.size() - (n_taps - 1);
+	history.erase(history.begin(), history.begin() + drop);
+	next -= drop;
+
+	if(output.empty()) return false;
+	buffer.write(output.data(), output.size(), t_capture);
+	return true;
+}
+
+unsigned Decimator::factor_for(const float f_stop, const float f_sample, const size_t fft_size, const size_t buf_size){
+	for(unsigned factor = 8; factor > 1; factor /= 2){
+		if(f_stop <= PASSBAND * f_sample / factor && fft_size % factor == 0 &&
+		   fft_size / factor >= MIN_SIZE && buf_size / factor >= MIN_SIZE){
+			return factor;
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,56 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Buffer.hpp"
+
+/*
+	Streaming FIR low-pass and downsampler, feeds a buffer with a factor times lower sample rate.
+
+	A spectrum that only shows low frequencies analyses the decimated buffer with a factor times
+	smaller fft, which keeps the bin spacing of the full rate fft at a fraction of the cost.
+*/
+class Decimator {
+	public:
+		Decimator(const unsigned factor, const size_t buf_size);
+
+		// filter the samples written to the source since the last update, returns true if the output changed
+		bool update(Buffer<int16_t>& source);
+
+		// largest supported factor (2, 4 or 8) whose passband still contains f_stop, 1 if decimation isn't possible
+		static unsigned factor_for(const float f_stop, const float f_sample, const size_t fft_size, const size_t buf_size);
+
+		const unsigned factor;
+		Buffer<int16_t> buffer;
+
+	private:
+		std::vector<float> taps;
+		// the last taps-1 input samples followed by the new ones
+		std::vector<float> history;
+		std::vector<int16_t> output;
+		// history index of the newest input sample of the next output
+		size_t next;
+		uint64_t received = 0; // source samples seen so far
+
+		void reset();
+};
@@ -0,0 +1,97 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EGLwindow.hpp"
+#include <stdexcept>
+#include <string>
+#include <sstream>
+
+// exts is a space separated list, prefixes of other extension names don't match
+static bool has_ext(const char* exts, const std::string& ext){
+	if(exts == nullptr) return false;
+
+	std::istringstream list(exts);
+	std::string name;
+	while(list >> name){
+		if(name == ext) return true;
+	}
+	return false;
+}
+
+EGLwindow::EGLwindow(){
+	// prefer the surfaceless platform, it doesn't need a display server or GPU
+	const char* client_exts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if(has_ext(client_exts, "EGL_MESA_platform_surfaceless")){
+		auto eglGetPlatformDisplayEXT = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}else{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major, minor;
+	if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)){
+		throw std::runtime_error("Can't initialize EGL display!");
+	}
+
+	const char* display_exts = eglQueryString(display, EGL_EXTENSIONS);
+	if(!has_ext(display_exts, "EGL_KHR_surfaceless_context")){
+		eglTerminate(display);
+
+		throw std::runtime_error("EGL doesn't support surfaceless contexts!");
+	}
+
+	EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	// without configless contexts any config that supports desktop GL will do, it's never used for a surface
+	EGLConfig config = EGL_NO_CONFIG_KHR;
+	if(!has_ext(display_exts, "EGL_KHR_no_config_context") && !has_ext(display_exts, "EGL_MESA_configless_context")){
+		EGLint config_attribs[] = {
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_NONE
+		};
+		EGLint n = 0;
+		if(!eglChooseConfig(display, config_attribs, &config, 1, &n) || n < 1){
+			eglTerminate(display);
+
+			throw std::runtime_error("No EGL config supports OpenGL!");
+		}
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+	ctx = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+	if(ctx == EGL_NO_CONTEXT){
+		eglTerminate(display);
+
+		throw std::runtime_error("Failed to create GL3.3 context!");
+	}
+
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx);
+}
+
+EGLwindow::~EGLwindow(){
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(display, ctx);
+	eglTerminate(display);
+}
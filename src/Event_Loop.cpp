@@ -0,0 +1,194 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Event_Loop.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+// events handled per epoll_wait call
+static const int MAX_EVENTS = 16;
+
+static std::runtime_error loop_error(const std::string& what){
+	return std::runtime_error(what + ": " + std::string(std::strerror(errno)));
+}
+
+Event_Loop::Event_Loop(){
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(epoll_fd < 0){
+		throw loop_error("Can't create epoll instance");
+	}
+
+	// steady_clock is CLOCK_MONOTONIC, frame deadlines are used as absolute timer values
+	timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(timer_fd < 0 || wake_fd < 0){
+		std::runtime_error e = loop_error("Can't create event loop fds");
+		for(int fd : {wake_fd, timer_fd, epoll_fd}){
+			if(fd >= 0) close(fd);
+		}
+		throw e;
+	}
+
+	for(int fd : {timer_fd, wake_fd}){
+		struct epoll_event ev = {};
+		ev.events = EPOLLIN;
+		ev.data.fd = fd;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+	}
+}
+
+Event_Loop::~Event_Loop(){
+	for(int fd : {signal_fd, wake_fd, timer_fd, epoll_fd}){
+		if(fd >= 0) close(fd);
+	}
+}
+
+void Event_Loop::add(const int fd, const Handler& handler){
+	struct epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+
+	int op = handlers.count(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	if(epoll_ctl(epoll_fd, op, fd, &ev) < 0){
+		throw loop_error("Can't add fd " + std::to_string(fd) + " to the event loop");
+	}
+	handlers[fd] = handler;
+}
+
+void Event_Loop::remove(const int fd){
+	if(handlers.erase(fd)){
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+	}
+}
+
+void Event_Loop::add_signal(const int sig, const Handler& handler){
+	sigset_t mask;
+	sigemptyset(&mask);
+	for(auto& s : signal_handlers){
+		sigaddset(&mask, s.first);
+	}
+	sigaddset(&mask, sig);
+
+	// the signals must not be delivered to any thread, otherwise the default action terminates the process
+	pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+	int fd = signalfd(signal_fd, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if(fd < 0){
+		throw loop_error("Can't create signalfd");
+	}
+	if(signal_fd < 0){
+		signal_fd = fd;
+		add(signal_fd, [this]{ read_signals(); });
+	}
+	signal_handlers[sig] = handler;
+}
+
+void Event_Loop::read_signals(){
+	struct signalfd_siginfo info;
+	while(read(signal_fd, &info, sizeof(info)) == sizeof(info)){
+		auto it = signal_handlers.find(info.ssi_signo);
+		if(it != signal_handlers.end()){
+			it->second();
+		}
+	}
+}
+
+void Event_Loop::run_until(const clock::time_point target){
+	if(target <= clock::now()){
+		poll();
+		return;
+	}
+
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(target.time_since_epoch()).count();
+	struct itimerspec spec = {};
+	spec.it_value.tv_sec = ns / 1000000000;
+	spec.it_value.tv_nsec = ns % 1000000000;
+	timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+	while(!dispatch(-1));
+}
+
+void Event_Loop::poll(){
+	dispatch(0);
+}
+
+void Event_Loop::notify(){
+	notifications++;
+	if(armed.exchange(false)){
+		uint64_t one = 1;
+		ssize_t rc = write(wake_fd, &one, sizeof(one));
+		(void) rc;
+	}
+}
+
+void Event_Loop::checkpoint(){
+	seen = notifications;
+}
+
+void Event_Loop::idle(){
+	armed = true;
+	// notifications before arming don't write the eventfd
+	if(notifications != seen){
+		armed = false;
+		return;
+	}
+
+	dispatch(-1);
+	armed = false;
+}
+
+bool Event_Loop::dispatch(const int timeout){
+	struct epoll_event events[MAX_EVENTS];
+	int n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+	if(n < 0 && errno != EINTR){
+		throw loop_error("epoll_wait failed");
+	}
+
+	bool expired = false;
+	for(int i = 0; i < n; i++){
+		int fd = events[i].data.fd;
+		if(fd == timer_fd || fd == wake_fd){
+			uint64_t count;
+			ssize_t rc = read(fd, &count, sizeof(count));
+			(void) rc;
+			expired |= fd == timer_fd;
+			continue;
+		}
+
+		// handlers may remove themselves or other fds
+		auto it = handlers.find(fd);
+		if(it != handlers.end()){
+			Handler handler = it->second;
+			handler();
+		}
+	}
+	return expired;
+}
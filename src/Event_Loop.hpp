@@ -0,0 +1,83 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+
+/*
+	Single epoll based event core of the render thread. File descriptors (X connection,
+	inotify, signals) are dispatched while the frame scheduler sleeps on a timerfd, so
+	events are handled as soon as they arrive instead of once per frame. Without damage
+	the render thread blocks in idle() until an fd becomes ready or an input calls
+	notify(), there are no periodic wakeups.
+*/
+class Event_Loop {
+	public:
+		using clock = std::chrono::steady_clock;
+		using Handler = std::function<void()>;
+
+		Event_Loop();
+		~Event_Loop();
+		Event_Loop(const Event_Loop&) = delete;
+
+		// call the handler whenever fd is readable, the handler has to consume the event
+		void add(const int fd, const Handler&);
+		void remove(const int fd);
+
+		// handle the signals through a signalfd, they are blocked in the calling thread
+		// and in all threads it creates afterwards
+		void add_signal(const int sig, const Handler&);
+
+		// dispatch events until the time point has passed, returns immediately for past time points
+		void run_until(const clock::time_point);
+		// dispatch the pending events without blocking
+		void poll();
+
+		// thread safe, wakes up a blocking idle()
+		void notify();
+		// remember the notifications seen so far, has to be called before the data is read
+		void checkpoint();
+		// block until at least one event has been dispatched or notify() has been called since the last checkpoint
+		void idle();
+
+	private:
+		int epoll_fd = -1;
+		int timer_fd = -1;
+		int wake_fd = -1;
+		int signal_fd = -1;
+
+		std::map<int, Handler> handlers;
+		std::map<int, Handler> signal_handlers;
+
+		std::atomic<uint64_t> notifications{0};
+		uint64_t seen = 0;
+		// set while idle() blocks, only then notify() has to write the eventfd
+		std::atomic<bool> armed{false};
+
+		// wait for events and dispatch them, returns true if the frame timer expired
+		bool dispatch(const int timeout);
+		void read_signals();
+};
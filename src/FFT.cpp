@@ -18,6 +18,7 @@
  */
 
 #include "FFT.hpp"
+#include "Trace.hpp"
 
 FFT::FFT(const size_t fft_size){
 	size = fft_size;
@@ -33,6 +34,7 @@ FFT::FFT(FFT&& f){
 	plan = f.plan;
 	window = std::move(f.window);
 	size = f.size;
+	t_capture = f.t_capture;
 
 	// invalidate pointers
 	f.input = nullptr;
@@ -63,8 +65,10 @@ void FFT::resize(const size_t nsize){
 	}
 }
 
+// returns true if the fft output has been updated
 template<typename T>
-void FFT::calculate(Buffer<T>& buffer){
+bool FFT::calculate(Buffer<T>& buffer){
+	TRACE_SCOPE("FFT::calculate");
 	// find smallest value for window function
 	unsigned window_size = std::min(size, buffer.size);
 	unsigned buffer_start = std::max(0u, static_cast<unsigned>(buffer.size) - window_size);
@@ -75,7 +79,8 @@ void FFT::calculate(Buffer<T>& buffer){
 
 	auto lock = buffer.lock();
 	if(buffer.new_data){
-		buffer.new_data = false;
+		buffer.consume();
+		t_capture = buffer.t_capture;
 
 		unsigned int i;
 		for(i = 0; i < window_size; i++){
@@ -91,8 +96,11 @@ void FFT::calculate(Buffer<T>& buffer){
 		}
 
 		// execute fft
+		TRACE_SCOPE("fftwf_execute");
 		fftwf_execute(plan);
+		return true;
 	}
+	return false;
 }
 
 // return the index of the bin with the highest magnitude
@@ -145,4 +153,4 @@ void FFT::calculate_window(const size_t w_size){
 	}
 }
 
-template void FFT::calculate(Buffer<int16_t>&);
+template bool FFT::calculate(Buffer<int16_t>&);
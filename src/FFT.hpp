@@ -40,13 +40,15 @@ class FFT {
 		FFT& operator=(FFT&&) = default;
 		~FFT();
 
-		template<typename T> void calculate(Buffer<T>&);
+		template<typename T> bool calculate(Buffer<T>&);
 		void resize(const size_t);
 
 		size_t max_bin(const size_t, const size_t);
 		std::vector<float> magnitudes(const float);
 
 		fftwf_complex* output;
+		// capture time of the newest sample in the fft input
+		Buffer<int16_t>::clock::time_point t_capture;
 	private:
 		float* input;
 		fftwf_plan plan;
@@ -18,9 +18,18 @@
  */
 
 #include "Fifo.hpp"
+#include "Trace.hpp"
+#include "Realtime.hpp"
 
 #include <stdexcept>
-#include <chrono>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
 
 Fifo::~Fifo(){
 	stop_stream();
@@ -33,56 +42,109 @@ void Fifo::stop_stream(){
 void Fifo::start_stream(const Module_Config::Input& input_config){
 	stop_stream();
 
-	stream.reset(new fifo_stream(buffers, input_config.file, input_config.latency));
+	stream.reset(new fifo_stream(buffers, input_config.file, input_config.latency, input_config.stereo ? 2 : 1, input_config.thread));
 }
 
-Fifo::fifo_stream::fifo_stream(Buffers::Ptr& buffs, const std::string& filename, const size_t buff_len) :
-		running(true),
+Fifo::fifo_stream::fifo_stream(Buffers::Ptr& buffs, const std::string& file, const size_t buff_len, const unsigned channels, const Module_Config::Thread& sched) :
 		pre_buffer(new int16_t[buff_len]),
-		buffer_length(buff_len),
-		buffers(buffs){
-	file.open(filename, std::ifstream::in | std::ifstream::binary);
+		buffer_size(buff_len * sizeof(int16_t)),
+		frame_size(channels * sizeof(int16_t)),
+		buffers(buffs),
+		filename(file){
+	open();
 
-	if(!file.is_open()) throw std::runtime_error("Unable to open FIFO file: " + filename + " !");
+	struct stat st;
+	is_fifo = fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
 
-	thread = std::thread([&]{
-		while (running){
-			read();
-		};
+	stop_fd = eventfd(0, EFD_NONBLOCK);
+	if(stop_fd < 0){
+		close(fd);
+		throw std::runtime_error("Can't create FIFO eventfd: " + std::string(std::strerror(errno)));
+	}
+
+	thread = std::thread([this, sched]{
+		TRACE_THREAD("fifo");
+		Realtime::apply(sched, "fifo");
+		run();
 	});
 }
+
 Fifo::fifo_stream::~fifo_stream(){
-	running = false;
+	// wake up the reader
+	uint64_t one = 1;
+	if(write(stop_fd, &one, sizeof(one)) < 0){
+		std::cerr << "Can't stop the FIFO reader!" << std::endl;
+	}
 	thread.join();
+
+	close(stop_fd);
+	if(fd >= 0) close(fd);
 };
 
-template<typename T>
-inline T clamp(const T n, const T min, const T max){
-	return std::max(min, std::min(n, max));
+// opening the fifo non-blocking doesn't wait for a writer
+void Fifo::fifo_stream::open(){
+	if(fd >= 0) close(fd);
+
+	fd = ::open(filename.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if(fd < 0) throw std::runtime_error("Unable to open FIFO file: " + filename + " !");
+	pending = 0;
 }
 
-// internal read function
-template<typename T>
-static void i_read(std::vector<Buffer<T>>& buffers, T buf[], size_t size){
-	size = size / 2;
-	if(buffers.size() > 1){
-		buffers[0].write_offset(buf, size, 2, 0);
-		buffers[1].write_offset(buf, size, 2, 1);
-	}else{
-		buffers[0].write(buf, size);
+void Fifo::fifo_stream::run(){
+	try{
+		struct pollfd fds[2] = {{fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+		while(true){
+			if(poll(fds, 2, -1) < 0){
+				if(errno == EINTR) continue;
+				throw std::runtime_error("FIFO poll failed: " + std::string(std::strerror(errno)));
+			}
+
+			if(fds[1].revents) return;
+
+			// hangups are reported until the data has been read and the fifo has been reopened
+			if(fds[0].revents & (POLLIN | POLLHUP | POLLERR)){
+				if(read()) continue;
+
+				if(is_fifo){
+					// the writer has closed the fifo, a new file descriptor blocks until the next writer has written data
+					open();
+					fds[0].fd = fd;
+				}else{
+					// a regular file has ended, only wait for the stop signal
+					fds[0].fd = -1;
+				}
+			}
+		}
+	}catch(std::runtime_error& e){
+		std::cerr << e.what() << std::endl;
 	}
 }
 
-void Fifo::fifo_stream::read(){
-	long s_read = file.readsome(reinterpret_cast<char*>(pre_buffer.get()), buffer_length * sizeof(int16_t));
-
-	if(s_read > 0){
-		std::lock_guard<std::mutex> lock(buffers->mut);
-		i_read(buffers->bufs, pre_buffer.get(), s_read);
+// read the available data, returns false at the end of the input
+bool Fifo::fifo_stream::read(){
+	TRACE_SCOPE("Fifo::read");
+	char* bytes = reinterpret_cast<char*>(pre_buffer.get());
+	ssize_t n_read = ::read(fd, bytes + pending, buffer_size - pending);
+	if(n_read < 0){
+		return errno == EAGAIN || errno == EINTR;
+	}else if(n_read == 0){
+		return false;
 	}
+	// the fifo doesn't report its latency, the samples are timestamped on arrival
+	auto t_capture = Buffers::clock::now();
 
-	int diff = buffer_length - s_read;
-	delay += diff / 4;
-	delay = clamp(delay, DELAY_MIN, DELAY_MAX);
-	std::this_thread::sleep_for(std::chrono::microseconds(delay));
+	// only pass complete frames, keep the rest for the next read
+	size_t length = pending + n_read;
+	size_t complete = length - length % frame_size;
+	if(complete > 0){
+		std::unique_lock<std::mutex> lock(buffers->mut, std::defer_lock);
+		{
+			TRACE_SCOPE("lock Buffers::mut");
+			lock.lock();
+		}
+		buffers->ingest(pre_buffer.get(), complete / sizeof(int16_t), t_capture);
+	}
+	pending = length - complete;
+	std::memmove(bytes, bytes + complete, pending);
+	return true;
 }
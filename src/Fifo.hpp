@@ -19,15 +19,11 @@
 
 #pragma once
 
-#include <fstream>
-
 #include "Input.hpp"
 #include <thread>
-#include <atomic>
-
-#define DELAY_MIN 500
-#define DELAY_MAX 5000
+#include <string>
 
+// reads interleaved 16 bit samples from a named pipe, e.g. the mpd fifo output
 class Fifo : public Input{
 public:
 	explicit Fifo(Buffers::Ptr& buffers) : buffers(buffers){};
@@ -38,23 +34,28 @@ public:
 
 	void stop_stream() override;
 private:
+	// reader thread, sleeps in poll until data arrives or the stream is stopped
 	struct fifo_stream{
-		std::atomic<bool> running;
 		std::unique_ptr<int16_t[]> pre_buffer;
-		int buffer_length;
+		size_t buffer_size; // in bytes
+		size_t frame_size; // bytes per sample of all channels
+		size_t pending = 0; // bytes of an incomplete frame at the start of pre_buffer
 
 		Buffers::Ptr& buffers;
+		std::string filename;
+		bool is_fifo;
 
+		int fd = -1;
+		int stop_fd = -1; // eventfd, signaled to stop the thread
 		std::thread thread;
-		std::ifstream file;
-
-		int delay = 100;
 
-		explicit fifo_stream(Buffers::Ptr&, const std::string&, const size_t);
+		explicit fifo_stream(Buffers::Ptr&, const std::string&, const size_t, const unsigned, const Module_Config::Thread&);
 
 		~fifo_stream();
 
-		void read();
+		void open();
+		void run();
+		bool read();
 	};
 
 	std::unique_ptr<fifo_stream> stream;
@@ -0,0 +1,211 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Frame_Scheduler.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <iomanip>
+
+// number of frames kept for statistics
+static const size_t WINDOW = 256;
+// time to busy wait before a frame starts in low latency mode
+static const std::chrono::microseconds SPIN_TIME(1000);
+// latency histogram resolution
+static const float LATENCY_BUCKET = 0.002;
+static const size_t LATENCY_BUCKETS = 100;
+
+using seconds = std::chrono::duration<float>;
+
+Histogram::Histogram(const size_t n): capacity(n){
+	samples.reserve(n);
+}
+
+void Histogram::add(const float x){
+	if(samples.size() < capacity){
+		samples.push_back(x);
+	}else{
+		samples[next] = x;
+	}
+	next = (next + 1) % capacity;
+}
+
+float Histogram::percentile(const float p) const{
+	if(samples.empty()) return 0;
+
+	std::vector<float> sorted(samples);
+	size_t i = std::min(static_cast<size_t>(p * sorted.size()), sorted.size() - 1);
+	std::nth_element(sorted.begin(), sorted.begin() + i, sorted.end());
+	return sorted[i];
+}
+
+float Histogram::mean() const{
+	if(samples.empty()) return 0;
+	return std::accumulate(samples.begin(), samples.end(), 0.f) / samples.size();
+}
+
+Frame_Scheduler::Frame_Scheduler(const int fps, const bool low_latency, const bool realtime, Event_Loop* loop):
+	loop(loop), h_frame(WINDOW), h_draw(WINDOW), h_swap(WINDOW), h_sleep(WINDOW), h_work(WINDOW), h_wakeup(WINDOW), h_latency(WINDOW), latency_count(LATENCY_BUCKETS, 0){
+	configure(fps, low_latency, realtime);
+
+	deadline = clock::now();
+	t_start = deadline;
+	t_mark = deadline;
+}
+
+void Frame_Scheduler::configure(const int fps, const bool low_latency, const bool realtime){
+	period = std::chrono::duration_cast<clock::duration>(seconds(1.f / std::max(fps, 1)));
+	this->low_latency = low_latency;
+	this->realtime = realtime;
+}
+
+float Frame_Scheduler::wait(){
+	deadline += period;
+
+	// skip missed frame slots without losing the alignment
+	clock::time_point now = clock::now();
+	if(now > deadline){
+		deadline += period * ((now - deadline) / period + 1);
+	}
+
+	if(!realtime){
+		// render as fast as possible
+		if(loop) loop->poll();
+	}else if(low_latency){
+		// finish the buffer swap just before the deadline
+		sleep_until(deadline - work_estimate());
+	}else{
+		sleep_until(deadline - period);
+	}
+
+	clock::time_point t_last = t_start;
+	t_start = clock::now();
+	h_sleep.add(seconds(t_start - t_mark).count());
+	t_mark = t_start;
+
+	float dt = seconds(t_start - t_last).count();
+	h_frame.add(dt);
+	frames++;
+	return realtime ? dt : seconds(period).count();
+}
+
+void Frame_Scheduler::idle(){
+	if(!loop) return;
+	loop->idle();
+
+	// the idle time doesn't count as frame or sleep time
+	deadline = clock::now();
+	t_start = deadline;
+	t_mark = deadline;
+}
+
+void Frame_Scheduler::drawn(){
+	clock::time_point now = clock::now();
+	h_draw.add(seconds(now - t_mark).count());
+	t_mark = now;
+}
+
+void Frame_Scheduler::swapped(const clock::time_point t_capture){
+	clock::time_point now = clock::now();
+	h_swap.add(seconds(now - t_mark).count());
+	h_work.add(seconds(now - t_start).count());
+	t_mark = now;
+
+	// only count frames that show new audio data, the latency is meaningless for offline rendering
+	if(realtime && t_capture > this->t_capture){
+		this->t_capture = t_capture;
+
+		float latency = seconds(now - t_capture).count();
+		h_latency.add(latency);
+		latency_count[std::min(static_cast<size_t>(latency / LATENCY_BUCKET), LATENCY_BUCKETS - 1)]++;
+	}
+}
+
+void Frame_Scheduler::report(std::ostream& os, const int n){
+	if(frames < n) return;
+	frames = 0;
+
+	os << 1.f / h_frame.mean() << " FPS, frame time p50/p95/p99: "
+	   << h_frame.percentile(0.5) * 1000 << "/" << h_frame.percentile(0.95) * 1000 << "/"
+	   << h_frame.percentile(0.99) * 1000 << " ms (draw " << h_draw.mean() * 1000 << " ms, swap "
+	   << h_swap.mean() * 1000 << " ms, sleep " << h_sleep.mean() * 1000 << " ms)" << std::endl;
+
+	if(h_wakeup.size() > 0){
+		os << "render wakeup latency p50/p99/max: " << h_wakeup.percentile(0.5) * 1e6 << "/"
+		   << h_wakeup.percentile(0.99) * 1e6 << "/" << h_wakeup.percentile(1) * 1e6 << " us" << std::endl;
+	}
+
+	if(h_latency.size() > 0){
+		os << "audio latency p50/p95/p99: " << h_latency.percentile(0.5) * 1000 << "/"
+		   << h_latency.percentile(0.95) * 1000 << "/" << h_latency.percentile(0.99) * 1000 << " ms" << std::endl;
+	}
+}
+
+void Frame_Scheduler::latency_histogram(std::ostream& os) const{
+	unsigned total = std::accumulate(latency_count.begin(), latency_count.end(), 0u);
+	if(total == 0) return;
+
+	// skip empty buckets at both ends
+	auto first = std::find_if(latency_count.begin(), latency_count.end(), [](unsigned n){ return n > 0; });
+	auto last = std::find_if(latency_count.rbegin(), latency_count.rend(), [](unsigned n){ return n > 0; }).base();
+	unsigned max = *std::max_element(first, last);
+
+	os << "audio latency histogram (" << total << " frames):" << std::endl;
+	for(auto it = first; it != last; it++){
+		size_t i = it - latency_count.begin();
+		os << std::setw(4) << i * LATENCY_BUCKET * 1000;
+		if(i == LATENCY_BUCKETS - 1){
+			os << "+     ms ";
+		}else{
+			os << " - " << std::setw(3) << (i + 1) * LATENCY_BUCKET * 1000 << " ms ";
+		}
+		os << std::setw(6) << *it << " " << std::string(*it * 50 / max, '#') << std::endl;
+	}
+}
+
+// sleep until the target time, with low_latency sleep until shortly before and spin for the rest
+// the events of the loop are dispatched every frame, also without time left to sleep
+void Frame_Scheduler::sleep_until(const clock::time_point target){
+	const clock::duration spin = low_latency ? clock::duration(SPIN_TIME) : clock::duration::zero();
+	const clock::time_point wake = target - spin;
+
+	if(wake > clock::now()){
+		if(loop){
+			loop->run_until(wake);
+		}else{
+			std::this_thread::sleep_until(wake);
+		}
+		h_wakeup.add(seconds(clock::now() - wake).count());
+	}else if(loop){
+		loop->poll();
+	}
+	while(clock::now() < target){
+		std::this_thread::yield();
+	}
+}
+
+// expected duration of drawing and swapping a frame
+Frame_Scheduler::clock::duration Frame_Scheduler::work_estimate() const{
+	// start at the beginning of the slot until enough frames have been measured
+	if(h_work.size() < WINDOW / 4) return period;
+
+	clock::duration work = std::chrono::duration_cast<clock::duration>(seconds(h_work.percentile(0.95)));
+	return std::min(work + SPIN_TIME, period);
+}
@@ -0,0 +1,89 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Event_Loop.hpp"
+
+#include <chrono>
+#include <vector>
+#include <ostream>
+
+// rolling window of samples for percentile statistics
+class Histogram {
+	public:
+		Histogram(const size_t);
+
+		void add(const float);
+		float percentile(const float) const;
+		float mean() const;
+		size_t size() const { return samples.size(); };
+
+	private:
+		std::vector<float> samples;
+		size_t capacity, next = 0;
+};
+
+// paces frames to a fixed rate and keeps frame time statistics
+class Frame_Scheduler {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		// events of the loop are dispatched while waiting for the next frame
+		Frame_Scheduler(const int fps, const bool low_latency, const bool realtime = true, Event_Loop* loop = nullptr);
+		void configure(const int fps, const bool low_latency, const bool realtime = true);
+
+		// wait for the start of the next frame, returns the time since the last frame start in seconds
+		// frames aren't paced without realtime, the returned time is always 1/fps
+		float wait();
+		// block until the event loop receives an event, the next frame starts without delay
+		void idle();
+		// mark the end of the draw phase
+		void drawn();
+		// mark the end of the buffer swap, t_capture is the capture time of the newest displayed sample
+		void swapped(const clock::time_point t_capture = clock::time_point());
+
+		// print frame time percentiles after n frames
+		void report(std::ostream&, const int n);
+		// print the distribution of the audio latency of all frames
+		void latency_histogram(std::ostream&) const;
+
+	private:
+		clock::duration period;
+		// start the frame as late as possible to reduce audio latency
+		bool low_latency;
+		bool realtime;
+		Event_Loop* loop;
+
+		clock::time_point deadline; // end of the current frame slot
+		clock::time_point t_start, t_mark;
+		int frames = 0;
+
+		Histogram h_frame, h_draw, h_swap, h_sleep, h_work;
+		// oversleep of the frame pacing sleep, shows the effect of the render thread scheduling
+		Histogram h_wakeup;
+
+		// age of new audio data when it reaches the screen
+		Histogram h_latency;
+		clock::time_point t_capture;
+		std::vector<unsigned> latency_count; // per LATENCY_BUCKET, the last one counts all larger values
+
+		void sleep_until(const clock::time_point);
+		clock::duration work_estimate() const;
+};
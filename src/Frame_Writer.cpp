@@ -0,0 +1,196 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Frame_Writer.hpp"
+
+#include <zlib.h>
+#include <stdexcept>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cctype>
+
+// number of frames in flight before the oldest one is read back
+static const size_t READBACK_DEPTH = 3;
+
+Frame_Writer::Frame_Writer(const Module_Config::Output& output, const int w, const int h):
+	pbos(READBACK_DEPTH), width(w), height(h), path(output.file), max_frames(output.frames){
+	// resolve target
+	tex.bind(GL_TEXTURE_2D);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	GL::Texture::unbind(GL_TEXTURE_2D);
+
+	fbo.bind();
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex.id, 0);
+	GL::FBO::unbind();
+
+	for(GL::Buffer& pbo : pbos){
+		pbo.bind(GL_PIXEL_PACK_BUFFER);
+		glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, nullptr, GL_STREAM_READ);
+	}
+	GL::Buffer::unbind(GL_PIXEL_PACK_BUFFER);
+
+	png = path.size() > 4 && path.compare(path.size() - 4, 4, ".png") == 0;
+	if(png){
+		parse_pattern();
+	}else{
+		file = path == "-" ? stdout : std::fopen(path.c_str(), "wb");
+		if(file == nullptr){
+			throw std::runtime_error("Can't open output file " + path + "!");
+		}
+	}
+}
+
+Frame_Writer::~Frame_Writer(){
+	flush();
+	if(file != nullptr && file != stdout){
+		std::fclose(file);
+	}
+}
+
+// png paths need exactly one frame number conversion like %d or %06d
+void Frame_Writer::parse_pattern(){
+	size_t pos = path.find('%');
+	if(pos == std::string::npos){
+		throw std::runtime_error("Output file " + path + " needs a %d for the frame number!");
+	}
+
+	size_t end = pos + 1;
+	if(end < path.size() && path[end] == '0'){
+		name_fill = '0';
+		end++;
+	}
+	while(end < path.size() && std::isdigit(static_cast<unsigned char>(path[end]))){
+		name_width = name_width * 10 + (path[end] - '0');
+		end++;
+	}
+	if(end >= path.size() || path[end] != 'd' || name_width > 32 || path.find('%', end) != std::string::npos){
+		throw std::runtime_error("Invalid frame number format in output file " + path + "!");
+	}
+
+	name_prefix = path.substr(0, pos);
+	name_suffix = path.substr(end + 1);
+}
+
+void Frame_Writer::capture(){
+	// the oldest readback has to be written before its buffer can be reused
+	if(pending == pbos.size()){
+		write(next);
+		pending--;
+	}
+
+	fbo.bind(GL_READ_FRAMEBUFFER);
+	pbos[next].bind(GL_PIXEL_PACK_BUFFER);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	GL::Buffer::unbind(GL_PIXEL_PACK_BUFFER);
+	GL::FBO::unbind(GL_READ_FRAMEBUFFER);
+
+	next = (next + 1) % pbos.size();
+	pending++;
+	captured++;
+}
+
+void Frame_Writer::flush(){
+	while(pending > 0){
+		write((next + pbos.size() - pending) % pbos.size());
+		pending--;
+	}
+	if(file != nullptr){
+		std::fflush(file);
+	}
+}
+
+void Frame_Writer::write(const size_t index){
+	const size_t stride = width * 4;
+
+	pbos[index].bind(GL_PIXEL_PACK_BUFFER);
+	const unsigned char* data = static_cast<const unsigned char*>(
+		glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, stride * height, GL_MAP_READ_BIT));
+
+	if(data != nullptr && !failed){
+		if(png){
+			write_png(data);
+		}else{
+			// GL rows are stored bottom up
+			for(int y = height - 1; y >= 0 && !failed; y--){
+				failed = std::fwrite(data + y * stride, 1, stride, file) != stride;
+			}
+		}
+		written++;
+	}
+
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	GL::Buffer::unbind(GL_PIXEL_PACK_BUFFER);
+
+	if(failed){
+		std::cerr << "Failed to write frame " << written << "!" << std::endl;
+	}
+}
+
+// png chunk with big endian length and crc
+static void png_chunk(std::FILE* f, const char* type, const unsigned char* data, const uint32_t length){
+	unsigned char len[4] = {(unsigned char)(length >> 24), (unsigned char)(length >> 16), (unsigned char)(length >> 8), (unsigned char)length};
+	uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+	// crc32 returns its initial value for null pointers
+	if(length > 0) crc = crc32(crc, data, length);
+	unsigned char crc_b[4] = {(unsigned char)(crc >> 24), (unsigned char)(crc >> 16), (unsigned char)(crc >> 8), (unsigned char)crc};
+
+	std::fwrite(len, 1, 4, f);
+	std::fwrite(type, 1, 4, f);
+	std::fwrite(data, 1, length, f);
+	std::fwrite(crc_b, 1, 4, f);
+}
+
+void Frame_Writer::write_png(const unsigned char* data){
+	const size_t stride = width * 4;
+
+	// prepend the filter type to every row
+	row_buffer.resize((stride + 1) * height);
+	for(int y = 0; y < height; y++){
+		unsigned char* row = &row_buffer[y * (stride + 1)];
+		row[0] = 0;
+		std::copy(data + (height - 1 - y) * stride, data + (height - y) * stride, row + 1);
+	}
+
+	std::vector<unsigned char> idat(compressBound(row_buffer.size()));
+	uLongf idat_size = idat.size();
+	compress2(idat.data(), &idat_size, row_buffer.data(), row_buffer.size(), Z_BEST_SPEED);
+
+	// 8 bit RGBA
+	unsigned char ihdr[13] = {
+		(unsigned char)(width >> 24), (unsigned char)(width >> 16), (unsigned char)(width >> 8), (unsigned char)width,
+		(unsigned char)(height >> 24), (unsigned char)(height >> 16), (unsigned char)(height >> 8), (unsigned char)height,
+		8, 6, 0, 0, 0
+	};
+	static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+	std::ostringstream name;
+	name << name_prefix << std::setfill(name_fill) << std::setw(name_width) << written << name_suffix;
+
+	std::FILE* f = std::fopen(name.str().c_str(), "wb");
+	if(f == nullptr){
+		failed = true;
+		return;
+	}
+	std::fwrite(signature, 1, 8, f);
+	png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+	png_chunk(f, "IDAT", idat.data(), idat_size);
+	png_chunk(f, "IEND", nullptr, 0);
+	failed = std::fclose(f) != 0;
+}
@@ -0,0 +1,69 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "GL_utils.hpp"
+#include "Module_Config.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// writes rendered frames to a pipe or numbered png files
+class Frame_Writer {
+	public:
+		Frame_Writer(const Module_Config::Output&, const int w, const int h);
+		~Frame_Writer();
+		Frame_Writer(const Frame_Writer&) = delete;
+
+		// framebuffer the frames have to be rendered into
+		inline const GL::FBO& target() const { return fbo; };
+
+		// start an asynchronous readback of the target framebuffer
+		void capture();
+		// write all pending frames
+		void flush();
+		// true if the frame limit is reached or the output failed
+		inline bool done() const { return failed || (max_frames > 0 && captured >= max_frames); };
+
+	private:
+		GL::FBO fbo;
+		GL::Texture tex;
+		// readback ring buffer, frames are written once the whole ring is in flight
+		std::vector<GL::Buffer> pbos;
+		size_t pending = 0, next = 0;
+
+		int width, height;
+		std::string path;
+		bool png;
+		// png file names are prefix, the zero or space padded frame number and suffix
+		std::string name_prefix, name_suffix;
+		int name_width = 0;
+		char name_fill = ' ';
+		std::FILE* file = nullptr;
+		long long max_frames, captured = 0, written = 0;
+		bool failed = false;
+
+		std::vector<unsigned char> row_buffer;
+
+		void write(const size_t);
+		void write_png(const unsigned char*);
+		void parse_pattern();
+};
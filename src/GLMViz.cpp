@@ -19,17 +19,33 @@
 
 #include "GLMViz.hpp"
 #include "Multisampler.hpp"
+#include "Program_Cache.hpp"
+#include "Frame_Scheduler.hpp"
+#include "Profiler.hpp"
+#include "Event_Loop.hpp"
+#include "Trace.hpp"
 
 #include <chrono>
 #include <csignal>
+#include <fstream>
+#include <cstdio>
 
-// config reload signal handler
-static_assert(ATOMIC_BOOL_LOCK_FREE, "std::atomic<bool> isn't lock free!");
-std::atomic<bool> config_reload(false);
+// reload the config on SIGUSR1 or after the file has been modified
+bool config_reload = false;
+// stop the mainloop
+bool closing = false;
 
-void sighandler(int signal){
-	config_reload = true;
-}
+#ifdef WITH_TRACE
+// write the recorded trace events on SIGUSR2
+bool trace_dump = false;
+#endif
+
+// redraw the next frame even if nothing has changed
+bool force_redraw = true;
+// nothing is animated and the input is live, wait for new data or events instead of drawing frames
+bool can_idle = false;
+// capture time of the newest audio sample in the current frame
+Frame_Scheduler::clock::time_point t_displayed;
 
 // set glClear color
 void set_bg_color(const Module_Config::Color& color){
@@ -38,12 +54,98 @@ void set_bg_color(const Module_Config::Color& color){
 
 std::string generate_title(const Config&);
 
-// create or delete renderers to match the corresponding configs
-template<typename R_vector, typename C_vector>
-void update_render_configs(R_vector&, C_vector&);
+#if defined(WITH_HEADLESS) || defined(WITH_TRANSPARENCY)
+// (re)create the multisample framebuffer, analytic anti-aliasing doesn't need one
+void update_msaa(std::unique_ptr<GL::Multisampler>& msaa, const Config& config, const int width, const int height){
+	if(config.analytic_aa){
+		msaa.reset();
+	}else if(!msaa || msaa->samples != config.w_aa){
+		msaa = ::make_unique<GL::Multisampler>(config.w_aa, width, height);
+		glEnable(GL_MULTISAMPLE);
+	}
+}
+#endif
+
+#if defined(WITH_HEADLESS)
+// headless mainloop
+template<typename Fupdate, typename Fdamage, typename Fdraw>
+void mainloop(Config& config, EGLwindow& window, Event_Loop& loop, Fupdate f_update, Fdamage f_damage, Fdraw f_draw){
+	int width = config.w_width;
+	int height = config.w_height;
+	glViewport(0, 0, width, height);
+	Frame_Writer writer(config.output, width, height);
+
+	// render into a multisample framebuffer and resolve it into the readback target
+	// analytic anti-aliasing renders directly into the readback target
+	std::unique_ptr<GL::Multisampler> msaa;
+	update_msaa(msaa, config, width, height);
+	Uniforms::Frame_Block frame_block;
+
+	Frame_Scheduler scheduler(config.fps, config.low_latency, !config.offline(), &loop);
+	GL::Profiler& profiler = GL::Profiler::get();
+	profiler.enabled = config.show_gpu_time;
+	// reloaded configs are parsed in the background
+	Config_Loader loader;
+	const unsigned st_resolve = profiler.stage("MSAA resolve");
+	while(!closing && !writer.done()){
+		if(config_reload){
+			std::cerr << "reloading config" << std::endl;
+			config_reload = false;
+			loader.request(config);
+		}
+		if(loader.poll(config)){
+			// reconfigure what differs from the previous config
+			f_update(loader.previous());
+			update_msaa(msaa, config, width, height);
+			scheduler.configure(config.fps, config.low_latency, !config.offline());
+			profiler.enabled = config.show_gpu_time;
+		}
+
+		// wait for the next frame slot
+		float dt = scheduler.wait();
+
+		// every frame is written, idle frames can't be skipped
+		f_damage(true);
+
+		if(msaa){
+			msaa->bind();
+		}else{
+			writer.target().bind();
+		}
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		// draw
+		frame_block.update(dt, width, height, config.analytic_aa);
+		f_draw(dt);
+		if(msaa){
+			profiler.begin(st_resolve);
+			msaa->blit(width, height, writer.target());
+			profiler.end();
+		}
+		scheduler.drawn();
+
+		{
+			TRACE_SCOPE("capture");
+			writer.capture();
+		}
+		scheduler.swapped(t_displayed);
+
+		if(config.show_fps){
+			scheduler.report(std::cerr, config.show_fps_interval);
+		}
+		if(config.show_gpu_time){
+			profiler.report(std::cerr, config.show_fps_interval);
+		}
+	}
+	writer.flush();
+
+	if(config.show_fps){
+		scheduler.latency_histogram(std::cerr);
+	}
+}
 
 // glfw specific code
-#ifndef WITH_TRANSPARENCY
+#elif !defined(WITH_TRANSPARENCY)
 
 // config reload key handler
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods){
@@ -55,6 +157,12 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 // handle window resizing
 void framebuffer_size_callback(GLFWwindow* window, int width, int height){
 	glViewport(0, 0, width, height);
+	force_redraw = true;
+}
+
+// redraw damaged window contents
+void window_refresh_callback(GLFWwindow* window){
+	force_redraw = true;
 }
 
 class glfw_error : public std::runtime_error{
@@ -71,60 +179,100 @@ public:
 };
 
 // glfw mainloop
-template<typename Fupdate, typename Fdraw>
-void mainloop(Config& config, GLFWwindow* window, Fupdate f_update, Fdraw f_draw){
-	std::chrono::time_point<std::chrono::steady_clock> t_start;
-	std::chrono::time_point<std::chrono::steady_clock> t_stop;
+template<typename Fupdate, typename Fdamage, typename Fdraw>
+void mainloop(Config& config, GLFWwindow* window, Event_Loop& loop, Fupdate f_update, Fdamage f_damage, Fdraw f_draw){
+	// the window is created without multisampling for analytic anti-aliasing, its sample count is fixed
+	// multisampling is only switched off when analytic anti-aliasing is enabled by a reload
+	Uniforms::Frame_Block frame_block;
+
+	Frame_Scheduler scheduler(config.fps, config.low_latency, !config.offline(), &loop);
+	GL::Profiler& profiler = GL::Profiler::get();
+	profiler.enabled = config.show_gpu_time;
+	// reloaded configs are parsed in the background
+	Config_Loader loader;
 	do{
 		if(config_reload){
 			std::cout << "reloading config" << std::endl;
 			config_reload = false;
-			config.reload();
-
+			loader.request(config);
+		}
+		if(loader.poll(config)){
 			// generate new title
 			std::string title = generate_title(config);
 			glfwSetWindowTitle(window, title.c_str());
 
-			// update uniforms, resize buffers
-			f_update();
+			// reconfigure what differs from the previous config
+			f_update(loader.previous());
+			if(config.analytic_aa){
+				glDisable(GL_MULTISAMPLE);
+			}else{
+				glEnable(GL_MULTISAMPLE);
+			}
+			scheduler.configure(config.fps, config.low_latency, !config.offline());
+			profiler.enabled = config.show_gpu_time;
+			force_redraw = true;
 		}
 
-		t_start = std::chrono::steady_clock::now();
-
-		glClear(GL_COLOR_BUFFER_BIT);
-
-		// draw
-		std::chrono::duration<float> dt = (t_start - t_stop);
-		f_draw(dt.count());
-
-		// Swap buffers
-		glfwSwapBuffers(window);
+		// wait for the next frame slot
+		float dt = scheduler.wait();
+
+		// upload new data, skip the frame if nothing has changed
+		bool damaged = f_damage(force_redraw);
+		if(damaged || !config.skip_idle_frames){
+			force_redraw = false;
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			// draw
+			int width, height;
+			glfwGetFramebufferSize(window, &width, &height);
+			frame_block.update(dt, width, height, config.analytic_aa);
+			f_draw(dt);
+			scheduler.drawn();
+
+			// Swap buffers
+			{
+				TRACE_SCOPE("swap");
+				glfwSwapBuffers(window);
+			}
+			scheduler.swapped(t_displayed);
+		}
 		glfwPollEvents();
 
-		// wait for fps timer
-		std::this_thread::sleep_until(t_start + std::chrono::microseconds(1000000 / config.fps - 100));
-		t_stop = t_start;
-	}while (glfwWindowShouldClose(window) == 0);
+		if(config.show_fps){
+			scheduler.report(std::cout, config.show_fps_interval);
+		}
+		if(config.show_gpu_time){
+			profiler.report(std::cout, config.show_fps_interval);
+		}
+	}while (!closing && glfwWindowShouldClose(window) == 0);
+
+	if(config.show_fps){
+		scheduler.latency_histogram(std::cout);
+	}
 }
 
 #else
 // glx mainloop
-bool closing = false;
-template <typename Fupdate, typename Fdraw>
-void mainloop(Config& config, GLXwindow& window, Fupdate f_update, Fdraw f_draw){
+template <typename Fupdate, typename Fdamage, typename Fdraw>
+void mainloop(Config& config, GLXwindow& window, Event_Loop& loop, Fupdate f_update, Fdamage f_damage, Fdraw f_draw){
 	Atom wm_delete_window = XInternAtom(window.display, "WM_DELETE_WINDOW", 0);
 	XSetWMProtocols(window.display, window.win, &wm_delete_window, 1);
 
 	int width = config.w_width;
 	int height = config.w_height;
-	// create multisample framebuffer
-	GL::Multisampler msaa(config.w_aa, width, height);
-	glEnable(GL_MULTISAMPLE);
-
-	std::chrono::time_point<std::chrono::steady_clock> t_start;
-	std::chrono::time_point<std::chrono::steady_clock> t_stop;
-	while(!closing){
-		// handle X events
+	// create multisample framebuffer, analytic anti-aliasing renders directly into the window
+	std::unique_ptr<GL::Multisampler> msaa;
+	update_msaa(msaa, config, width, height);
+	Uniforms::Frame_Block frame_block;
+
+	Frame_Scheduler scheduler(config.fps, config.low_latency, !config.offline(), &loop);
+	GL::Profiler& profiler = GL::Profiler::get();
+	profiler.enabled = config.show_gpu_time;
+	// reloaded configs are parsed in the background
+	Config_Loader loader;
+	const unsigned st_resolve = profiler.stage("MSAA resolve");
+
+	auto handle_x_events = [&]{
 		while(XPending(window.display) > 0){
 			XEvent event;
 			XNextEvent(window.display, &event);
@@ -145,50 +293,104 @@ void mainloop(Config& config, GLXwindow& window, Fupdate f_update, Fdraw f_draw)
 					height = wattr.height;
 
 					glViewport(0, 0, width, height);
-					msaa.resize(config.w_aa, width, height);
+					if(msaa){
+						msaa->resize(config.w_aa, width, height);
+					}
 				}
+				force_redraw = true;
 				break;
 			}
 		}
+	};
+	// X events are dispatched as soon as they arrive, also while waiting for the next frame
+	loop.add(ConnectionNumber(window.display), handle_x_events);
+
+	while(!closing){
+		// handle X events queued by Xlib, e.g. while swapping buffers
+		handle_x_events();
 
 		if(config_reload){
 			std::cout << "reloading config" << std::endl;
 			config_reload = false;
-			config.reload();
-
+			loader.request(config);
+		}
+		if(loader.poll(config)){
 			// generate new title
 			std::string title = generate_title(config);
 			window.set_title(title);
 
-			// update uniforms, resize buffers
-			f_update();
+			// reconfigure what differs from the previous config
+			f_update(loader.previous());
+			update_msaa(msaa, config, width, height);
+			scheduler.configure(config.fps, config.low_latency, !config.offline());
+			profiler.enabled = config.show_gpu_time;
+			force_redraw = true;
 		}
 
-		t_start = std::chrono::steady_clock::now();
+		// wait for the next frame slot
+		float dt = scheduler.wait();
 
-		msaa.bind();
-		glClear(GL_COLOR_BUFFER_BIT);
+		// upload new data, skip the frame if nothing has changed
+		loop.checkpoint();
+		bool damaged = f_damage(force_redraw);
+		if(damaged || !config.skip_idle_frames){
+			force_redraw = false;
+			if(msaa){
+				msaa->bind();
+			}
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			// draw
+			frame_block.update(dt, width, height, config.analytic_aa);
+			f_draw(dt);
+			if(msaa){
+				profiler.begin(st_resolve);
+				msaa->blit(width, height);
+				profiler.end();
+			}
+			scheduler.drawn();
 
-		// draw
-		std::chrono::duration<float> dt = (t_start - t_stop);
-		f_draw(dt.count());
+			// Swap buffers
+			{
+				TRACE_SCOPE("swap");
+				window.swapBuffers();
+			}
+			scheduler.swapped(t_displayed);
+		}else if(can_idle && !config_reload && !loader.pending() && !closing && XPending(window.display) == 0){
+			// sleep until the input delivers new samples or an event arrives
+			scheduler.idle();
+		}
 
-		// Swap buffers
-		msaa.blit(width, height);
-		window.swapBuffers();
-		//glfwPollEvents();
+		if(config.show_fps){
+			scheduler.report(std::cout, config.show_fps_interval);
+		}
+		if(config.show_gpu_time){
+			profiler.report(std::cout, config.show_fps_interval);
+		}
+	}
 
-		// wait for fps timer
-		std::this_thread::sleep_until(t_start + std::chrono::microseconds(1000000 / config.fps -100));
-		t_stop = t_start;
+	loop.remove(ConnectionNumber(window.display));
+
+	if(config.show_fps){
+		scheduler.latency_histogram(std::cout);
 	}
 }
 #endif
 
-void print_fps(int&, const int, float&, const float);
 inline float normalize_rms(float, float, float);
 Input::Ptr make_input(const Module_Config::Input&, Buffers::Ptr&);
-void configure_input(const Config&, Input::Ptr&, Buffers::Ptr&, std::vector<FFT>&);
+
+// sample accounting of the input path
+struct Input_Stats {
+	Buffer<int16_t>::Stats samples;
+	uint64_t overruns, frames, stale_frames;
+};
+Input_Stats input_stats(Buffers&, const uint64_t, const uint64_t);
+void print_input_stats(std::ostream&, const Input_Stats&);
+void write_input_stats(const std::string&, const Input_Stats&);
+void configure_ffts(const Config&, const Buffers&, std::vector<FFT>&);
+void configure_decimation(const Config&, std::vector<Decimator>&, std::vector<FFT>&);
+void configure_recording(const Module_Config::Input&, Buffers&);
 
 int main(int argc, char* argv[]){
 	try{
@@ -197,8 +399,27 @@ int main(int argc, char* argv[]){
 		if(argc > 1){
 			config_file = argv[1];
 		}
+		TRACE_THREAD("render");
+		// signals are blocked before any other thread is started
+		Event_Loop loop;
+		loop.add_signal(SIGUSR1, []{ config_reload = true; });
+#ifdef WITH_TRACE
+		loop.add_signal(SIGUSR2, []{ trace_dump = true; });
+#endif
+#ifdef WITH_HEADLESS
+		// stop rendering on SIGINT/SIGTERM and write the pending frames
+		loop.add_signal(SIGINT, []{ closing = true; });
+		loop.add_signal(SIGTERM, []{ closing = true; });
+#endif
+
 		// read config
 		Config config(config_file);
+		Realtime::apply(config.render_thread, "render");
+
+#ifdef WITH_HEADLESS
+		// keep stdout free for frame output, log messages go to stderr
+		std::cout.rdbuf(std::cerr.rdbuf());
+#endif
 
 		// create audio buffer
 		Buffers::Ptr p_buffers = std::make_shared<Buffers>();
@@ -213,19 +434,33 @@ int main(int argc, char* argv[]){
 			ffts.emplace_back(config.fft.size);
 		}
 
-		Config_Monitor cm(config.get_file(), config_reload);
-		// start input thread
+		// decimated analysis of the spectra that only show low frequencies
+		std::vector<Decimator> decimators;
+		std::vector<FFT> decimated_ffts;
+		configure_decimation(config, decimators, decimated_ffts);
+
+		Config_Monitor cm(config.get_file(), loop, []{ config_reload = true; });
+		// start input thread, new samples wake up the idle render thread
+		p_buffers->notify = [&loop]{ loop.notify(); };
 		std::unique_ptr<Input> input = make_input(config.input, p_buffers);
+		configure_recording(config.input, *p_buffers);
 		input->start_stream(config.input);
-
-		// attach SIGUSR1 signal handler
-		std::signal(SIGUSR1, sighandler);
-
-#ifndef WITH_TRANSPARENCY
+		// reloaded input configurations are started in the background
+		Input_Switcher switcher(config.input, [&loop](const Module_Config::Input& i, Buffers::Ptr& buffers){
+			buffers->notify = [&loop]{ loop.notify(); };
+			return make_input(i, buffers);
+		});
+
+#if defined(WITH_HEADLESS)
+		// a closed output pipe is reported as write error
+		std::signal(SIGPIPE, SIG_IGN);
+
+		EGLwindow window;
+#elif !defined(WITH_TRANSPARENCY)
 		// init GLFW
 		GLFW glfw;
 
-		glfwWindowHint(GLFW_SAMPLES, config.w_aa);
+		glfwWindowHint(GLFW_SAMPLES, config.analytic_aa ? 0 : config.w_aa);
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -244,6 +479,7 @@ int main(int argc, char* argv[]){
 
 		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 		glfwSetKeyCallback(window, key_callback);
+		glfwSetWindowRefreshCallback(window, window_refresh_callback);
 #else
 		GLXwindow window(config.w_width, config.w_height);
 
@@ -266,19 +502,29 @@ int main(int argc, char* argv[]){
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		glEnable(GL_BLEND);
 
-		std::vector<Spectrum> spectra;
-		std::vector<Oscilloscope> oscilloscopes;
+		// batched renderers of all spectra and oscilloscopes
+		Spectrum spectra;
+		Oscilloscope oscilloscopes;
+
+		spectra.configure(config.spectra);
+		oscilloscopes.configure(config.oscilloscopes);
 
-		// create new renderers
-		update_render_configs(spectra, config.spectra);
-		update_render_configs(oscilloscopes, config.oscilloscopes);
+		if(config.show_fps){
+			const GL::Program_Cache& cache = GL::Program_Cache::get();
+			std::cout << "Shader setup: " << cache.link_time * 1000 << " ms (" << cache.hits << " cached, "
+				<< cache.misses << " compiled)" << std::endl;
+		}
+
+		// drawn frames and those of them drawn without new audio data
+		uint64_t frames = 0, stale_frames = 0;
 
-		float fps_sum = 0;
-		int fps_interval = 0;
+		mainloop(config, window, loop,
+				 [&](const Config& old){
+					 if(!(old.render_thread == config.render_thread)){
+						 Realtime::apply(config.render_thread, "render");
+					 }
 
-		mainloop(config, window,
-				 [&]{
-					 // resize buffers and reconfigure renderer
+					 // resize buffers and ffts, both keep their memory if the size didn't change
 					 for (auto& buf : p_buffers->bufs){
 						 buf.resize(config.buf_size);
 					 }
@@ -287,37 +533,111 @@ int main(int argc, char* argv[]){
 						 fft.resize(config.fft.size);
 					 }
 
-					 configure_input(config, input, p_buffers, ffts);
+					 // the new input is started in the background and swapped in by f_damage
+					 if(!(old.input == config.input)){
+						 switcher.request(config.input, config.buf_size, input);
+					 }else if(old.input.record != config.input.record){
+						 // the running input keeps going, only the recording changes
+						 configure_recording(config.input, *p_buffers);
+					 }
+					 if(!(old.decimation == config.decimation) || old.buf_size != config.buf_size || !(old.fft == config.fft)){
+						 configure_decimation(config, decimators, decimated_ffts);
+					 }
 
-					 update_render_configs(spectra, config.spectra);
-					 update_render_configs(oscilloscopes, config.oscilloscopes);
+					 // the renderers only update the instances whose parameters changed
+					 if(!(old.spectra == config.spectra)){
+						 spectra.configure(config.spectra);
+					 }
+					 if(!(old.oscilloscopes == config.oscilloscopes)){
+						 oscilloscopes.configure(config.oscilloscopes);
+					 }
 
-					 set_bg_color(config.bg_color);
+					 if(!(old.bg_color == config.bg_color)){
+						 set_bg_color(config.bg_color);
+					 }
 				 },
-				 [&](const float dt){
-					 if(config.show_fps){
-						 print_fps(fps_interval, config.show_fps_interval, fps_sum, dt);
+				 [&](const bool force){
+#ifdef WITH_TRACE
+					 if(trace_dump){
+						 trace_dump = false;
+						 Trace::dump(config.trace_file);
+					 }
+#endif
+					 if(switcher.poll(input, p_buffers)){
+						 // buf_size may have been reloaded while the input was switching
+						 for(auto& buf : p_buffers->bufs){
+							 buf.resize(config.buf_size);
+						 }
+						 // the replaced buffers and their recorder are gone, the new recording can't overlap the old one
+						 Module_Config::Input recorded = switcher.current();
+						 recorded.record = config.input.record;
+						 configure_recording(recorded, *p_buffers);
+						 configure_ffts(config, *p_buffers, ffts);
+						 configure_decimation(config, decimators, decimated_ffts);
+					 }
+
+					 // offline inputs are fed one frame at a time, there is no input while switching
+					 if(input && input->is_offline() && !input->read_frame(config.fps)){
+						 std::cout << "end of input" << std::endl;
+						 closing = true;
 					 }
+
 					 // update all locking renderer first
+					 bool fft_updated = false;
 					 for (unsigned i = 0; i < ffts.size(); i++){
-						 ffts[i].calculate(p_buffers->bufs[i]);
+						 fft_updated |= ffts[i].calculate(p_buffers->bufs[i]);
+					 }
+					 for (unsigned i = 0; i < decimators.size(); i++){
+						 size_t channel = std::min<size_t>(config.decimation[i].channel, p_buffers->bufs.size() - 1);
+						 decimators[i].update(p_buffers->bufs[channel]);
+						 fft_updated |= decimated_ffts[i].calculate(decimators[i].buffer);
+					 }
+					 bool fft_damaged = force || fft_updated;
+					 if(fft_damaged){
+						 spectra.update_fft(ffts, decimated_ffts);
 					 }
 
 					 // test rms calculation
 					 //std::cout << "RMS: " << 20 * std::log10(normalize_rms(buffer.rms(), buffer.size, 1<<15)) << "dB" << std::endl;
-					 for (Oscilloscope& o : oscilloscopes){
-						 o.update_buffer(p_buffers->bufs);
+					 bool osc_damaged = oscilloscopes.update_buffer(p_buffers->bufs);
+
+					 t_displayed = std::max(spectra.captured(), oscilloscopes.captured());
+
+					 // falling bars have to be animated until they reach the fft values
+					 bool damaged = fft_damaged || osc_damaged || !spectra.settled();
+					 // offline inputs and pending input switches have to be polled every frame
+					 can_idle = !damaged && input && !input->is_offline() && !switcher.pending();
+
+					 // only drawn frames are counted, frames skipped by skip_idle_frames aren't
+					 if(damaged || !config.skip_idle_frames){
+						 frames++;
+						 if(!fft_updated && !osc_damaged){
+							 stale_frames++;
+						 }
+						 if(frames % std::max(config.show_fps_interval, 1) == 0){
+							 Input_Stats stats = input_stats(*p_buffers, frames, stale_frames);
+							 if(config.show_fps){
+								 print_input_stats(std::cout, stats);
+								 if(input) input->report(std::cout);
+							 }
+							 if(!config.stats_file.empty()){
+								 write_input_stats(config.stats_file, stats);
+							 }
+						 }
 					 }
+
+					 return damaged;
+				 },
+				 [&](const float dt){
 					 // draw spectra and oscilloscopes
-					 for (Spectrum& s : spectra){
-						 s.update_fft(ffts);
-						 s.draw(dt);
-					 }
-					 for (Oscilloscope& o : oscilloscopes){
-						 o.draw();
-					 }
+					 spectra.draw();
+					 oscilloscopes.draw();
 				 });
 
+#ifdef WITH_TRACE
+		Trace::dump(config.trace_file);
+#endif
+
 	}catch (std::runtime_error& e){
 		// print error message and terminate with error code 1
 		std::cerr << e.what() << std::endl;
@@ -327,20 +647,48 @@ int main(int argc, char* argv[]){
 	return 0;
 }
 
-void print_fps(int& fps_interval, const int max_count, float& sum, const float dt){
-	if(fps_interval >= max_count){
-		fps_interval = 0;
+inline float normalize_rms(float sum, float length, float amplitude){
+	// rms normalization: divide sum by buffer length times 4^15(max amplitude)
+	return std::sqrt(sum / (length * amplitude * amplitude));
+}
 
-		std::cout << max_count/sum << " FPS" << std::endl;
-		sum = 0;
+// sum the counters of all channels
+Input_Stats input_stats(Buffers& buffers, const uint64_t frames, const uint64_t stale_frames){
+	Input_Stats stats = {};
+	stats.overruns = buffers.overruns;
+	stats.frames = frames;
+	stats.stale_frames = stale_frames;
+
+	std::lock_guard<std::mutex> lock(buffers.mut);
+	for(auto& buf : buffers.bufs){
+		auto buf_lock = buf.lock();
+		stats.samples.received += buf.stats.received;
+		stats.samples.truncated += buf.stats.truncated;
+		stats.samples.overwritten += buf.stats.overwritten;
 	}
-	fps_interval++;
-	sum += dt;
+	return stats;
 }
 
-inline float normalize_rms(float sum, float length, float amplitude){
-	// rms normalization: divide sum by buffer length times 4^15(max amplitude)
-	return std::sqrt(sum / (length * amplitude * amplitude));
+void print_input_stats(std::ostream& os, const Input_Stats& stats){
+	os << "input: " << stats.samples.received << " samples received, " << stats.samples.truncated << " truncated, "
+	   << stats.samples.overwritten << " overwritten before analysis, " << stats.overruns << " overruns, "
+	   << stats.stale_frames << "/" << stats.frames << " frames with stale data" << std::endl;
+}
+
+// write the counters as json, the file is replaced atomically
+void write_input_stats(const std::string& file, const Input_Stats& stats){
+	std::string tmp = file + ".tmp";
+	{
+		std::ofstream os(tmp, std::ofstream::trunc);
+		if(!os.is_open()){
+			std::cerr << "Can't write stats file " << file << "!" << std::endl;
+			return;
+		}
+		os << "{\"received\":" << stats.samples.received << ",\"truncated\":" << stats.samples.truncated
+		   << ",\"overwritten\":" << stats.samples.overwritten << ",\"overruns\":" << stats.overruns
+		   << ",\"frames\":" << stats.frames << ",\"stale_frames\":" << stats.stale_frames << "}" << std::endl;
+	}
+	std::rename(tmp.c_str(), file.c_str());
 }
 
 Input::Ptr make_input(const Module_Config::Input& i, Buffers::Ptr& buffers){
@@ -351,48 +699,60 @@ Input::Ptr make_input(const Module_Config::Input& i, Buffers::Ptr& buffers){
 		case Module_Config::Source::PULSE:
 			return ::make_unique<Pulse_Async>(buffers);
 #endif
+#ifdef WITH_ALSA
+		case Module_Config::Source::ALSA:
+			return ::make_unique<Alsa_Input>(buffers);
+#endif
+		case Module_Config::Source::FILE:
+			return ::make_unique<Audio_File>(buffers);
+		case Module_Config::Source::REPLAY:
+			return ::make_unique<Replay>(buffers);
+		case Module_Config::Source::SHM:
+			return ::make_unique<Shm_Input>(buffers);
+		case Module_Config::Source::UDP:
+		case Module_Config::Source::RTP:
+			return ::make_unique<Net_Input>(buffers);
 		default:
 			return ::make_unique<Fifo>(buffers);
 	}
 }
 
-void configure_input(const Config& config, Input::Ptr& input, Buffers::Ptr& buffers, std::vector<FFT>& ffts){
-	// check if input configuration has changed
-	if(config.old_input == config.input){
-		return;
+// rebuild the decimators and their ffts, the filters restart with the newest buffered samples
+void configure_decimation(const Config& config, std::vector<Decimator>& decimators, std::vector<FFT>& ffts){
+	decimators.clear();
+	ffts.clear();
+	for(const Module_Config::Decimation& d : config.decimation){
+		decimators.emplace_back(d.factor, config.buf_size);
+		ffts.emplace_back(config.fft.size / d.factor);
 	}
+}
 
-	if(config.old_input.source == config.input.source){
-		// stop stream
-		input->stop_stream();
-	}else{
-		// create new stream using different audio API
-		input.reset(nullptr);
+// match the number of channel ffts to the input buffers
+void configure_ffts(const Config& config, const Buffers& buffers, std::vector<FFT>& ffts){
+	while(ffts.size() < buffers.bufs.size()){
+		ffts.emplace_back(config.fft.size);
 	}
-
-	{
-		// start stream after releasing the lock
-		std::lock_guard<std::mutex> lock(buffers->mut);
-		// create new buffers/ffts
-		if(config.input.stereo && buffers->bufs.size() < 2){
-			buffers->bufs.emplace_back(config.buf_size);
-			ffts.emplace_back(config.fft.size);
-		}
-		// destroy buffers/ffts
-		if(!config.input.stereo && buffers->bufs.size() > 1){
-			buffers->bufs.pop_back();
-			ffts.pop_back();
-		}
-		std::cout << "Input Buffers: " << buffers->bufs.size() << std::endl;
+	while(ffts.size() > buffers.bufs.size()){
+		ffts.pop_back();
 	}
+}
 
-	if(config.old_input.source != config.input.source){
-		// create new audio stream
-		input = make_input(config.input, buffers);
+// tee the input blocks into a recording, a changed input or record file starts a new recording
+void configure_recording(const Module_Config::Input& i, Buffers& buffers){
+	Buffers::Tap tap;
+	if(!i.record.empty()){
+		std::shared_ptr<Recorder> recorder = std::make_shared<Recorder>(i.record, i.f_sample, i.stereo ? 2 : 1);
+		tap = [recorder](const int16_t buf[], const size_t n, const Buffers::clock::time_point t){
+			recorder->write(buf, n, t);
+		};
+		std::cout << "Recording input to " << i.record << std::endl;
 	}
 
-	input->start_stream(config.input);
-
+	{
+		std::lock_guard<std::mutex> lock(buffers.mut);
+		std::swap(buffers.tap, tap);
+	}
+	// the previous recorder writes its remaining blocks without blocking the input
 }
 
 std::string generate_title(const Config& config){
@@ -407,20 +767,3 @@ std::string generate_title(const Config& config){
 	}
 	return title.str();
 }
-
-template<typename R_vector, typename C_vector>
-void update_render_configs(R_vector& renderer, C_vector& configs){
-	for (unsigned i = 0; i < configs.size(); i++){
-		try{
-			//reconfigure renderer
-			renderer.at(i).configure(configs[i]);
-		}catch (std::out_of_range& e){
-			//make new renderer
-			renderer.emplace_back(configs[i], i);
-		}
-	}
-	//delete remaining renderers
-	if(renderer.size() > configs.size()){
-		renderer.erase(renderer.begin() + configs.size(), renderer.end());
-	}
-}
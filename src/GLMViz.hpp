@@ -29,7 +29,10 @@
 // Include basic GL utility headers
 #include "GL_utils.hpp"
 
-#ifndef WITH_TRANSPARENCY
+#if defined(WITH_HEADLESS)
+#include "EGLwindow.hpp"
+#include "Frame_Writer.hpp"
+#elif !defined(WITH_TRANSPARENCY)
 #include <GLFW/glfw3.h>
 #else
 #include "GLXwindow.hpp"
@@ -39,33 +42,32 @@
 #include "FFT.hpp"
 #include "Input.hpp"
 #include "Fifo.hpp"
+#include "Audio_File.hpp"
+#include "Replay.hpp"
+#include "Shm_Input.hpp"
+#include "Net_Input.hpp"
+#include "Input_Switcher.hpp"
+#include "Realtime.hpp"
+#include "Recorder.hpp"
 #include "Buffer.hpp"
 #include "Config.hpp"
+#include "Config_Loader.hpp"
 #include "Config_Monitor.hpp"
 #include "Spectrum.hpp"
+#include "Decimator.hpp"
 #include "Oscilloscope.hpp"
 
 #ifdef WITH_PULSE
 #include "Pulse_Async.hpp"
 #endif
 
+#ifdef WITH_ALSA
+#include "Alsa_Input.hpp"
+#endif
+
 // make_unique template for backwards compatibility
 template<typename T, typename... Args>
 std::unique_ptr<T> make_unique(Args&&... args)
 {
     return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
 }
-
-class Config_Monitor{
-	public:
-		Config_Monitor(const std::string& file, std::atomic<bool>& reload):
-			running(true),
-			th_monitor(monitor, file, std::ref(running), std::ref(reload))
-		{};
-
-		~Config_Monitor(){ running = false; th_monitor.join(); };
-
-	private:
-		std::atomic<bool> running;
-		std::thread th_monitor;
-};
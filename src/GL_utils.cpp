@@ -33,6 +33,32 @@ void Program::check_link_status() {
 	}
 }
 
+bool Program::load_binary(const GLenum format, const std::vector<char>& binary) {
+	glProgramBinary(id, format, binary.data(), binary.size());
+
+	GLint link_status;
+	glGetProgramiv(id, GL_LINK_STATUS, &link_status);
+
+	// flush errors caused by unsupported binary formats
+	while(glGetError() != GL_NO_ERROR);
+
+	return link_status == GL_TRUE;
+}
+
+bool Program::get_binary(GLenum& format, std::vector<char>& binary) const {
+	GLint length = 0;
+	glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0) {
+		return false;
+	}
+
+	binary.resize(length);
+	glGetProgramBinary(id, length, &length, &format, binary.data());
+	binary.resize(length);
+
+	return length > 0;
+}
+
 Shader::Shader(const char* code, GLuint type) {
 	id = glCreateShader(type);
 
@@ -8,6 +8,7 @@
 #endif
 
 #include <vector>
+#include <cstddef>
 
 /*!
 	\file
@@ -38,6 +39,27 @@ struct Buffer {
 
 	inline void tfbind() { glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, id); };
 
+	/*!
+		Binds a range of the buffer as transform feedback buffer.
+		\param offset start of the range in bytes
+		\param size size of the range in bytes
+	*/
+	inline void tfbind(GLintptr offset, GLsizeiptr size) { glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, id, offset, size); };
+
+	/*!
+		Binds the buffer to an indexed GL_UNIFORM_BUFFER binding point.
+		\param index binding point
+	*/
+	inline void ubobind(GLuint index) const noexcept { glBindBufferBase(GL_UNIFORM_BUFFER, index, id); };
+
+	/*!
+		Binds a range of the buffer to an indexed GL_UNIFORM_BUFFER binding point.
+		\param index binding point
+		\param offset start of the range, has to be a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+		\param size size of the range in bytes
+	*/
+	inline void ubobind(GLuint index, GLintptr offset, GLsizeiptr size) const noexcept { glBindBufferRange(GL_UNIFORM_BUFFER, index, id, offset, size); };
+
 	/*!
 		Binds the buffer to the GL_ARRAY_BUFFER target.
 	*/
@@ -152,6 +174,22 @@ public:
 	*/
 	void check_link_status();
 
+	/*!
+		Replace the Program with a previously retrieved program binary.
+		\param format driver specific binary format
+		\param binary program binary
+		\return false if the driver rejected the binary
+	*/
+	bool load_binary(const GLenum format, const std::vector<char>& binary);
+
+	/*!
+		Retrieve the binary of a linked Program.
+		\param format driver specific binary format
+		\param binary program binary
+		\return false if no binary is available
+	*/
+	bool get_binary(GLenum& format, std::vector<char>& binary) const;
+
 	/*!
 		Attach multiple shaders to program.
 		\param shs shaders to attach
@@ -198,6 +236,17 @@ public:
 	*/
 	inline GLint get_attrib(const char* name) const { return glGetAttribLocation(id, name); };
 
+	/*!
+		Assign a uniform block to an indexed binding point.
+		Blocks which aren't used by the Program are ignored.
+		\param name Uniform block name
+		\param binding binding point
+	*/
+	inline void bind_uniform_block(const char* name, GLuint binding) const {
+		GLuint index = glGetUniformBlockIndex(id, name);
+		if(index != GL_INVALID_INDEX) glUniformBlockBinding(id, index, binding);
+	};
+
 private:
 	GLuint id; //!< Program handle
 };
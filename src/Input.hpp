@@ -21,6 +21,7 @@
 
 #include "Buffer.hpp"
 #include <memory>
+#include <ostream>
 #include "Module_Config.hpp"
 
 class Input {
@@ -30,4 +31,11 @@ class Input {
 		virtual ~Input() {};
 		virtual void start_stream(const Module_Config::Input&) = 0;
 		virtual void stop_stream() = 0;
+
+		// offline inputs are read by the render loop instead of a realtime thread
+		virtual bool is_offline() const { return false; };
+		// feed the samples of the next frame into the buffers, returns false at the end of the input
+		virtual bool read_frame(const int fps) { return true; };
+		// print input specific statistics
+		virtual void report(std::ostream&) const {};
 };
@@ -0,0 +1,148 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Input_Switcher.hpp"
+#include "Realtime.hpp"
+#include "Trace.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+// silent inputs are handed over after this time
+static const std::chrono::milliseconds HANDOVER_TIMEOUT(1000);
+
+Input_Switcher::~Input_Switcher(){
+	finish();
+}
+
+void Input_Switcher::request(const Module_Config::Input& input_config, const size_t buf_size, Input::Ptr& current){
+	// the running switch can't be interrupted, the newest request is started once it finished
+	if(worker.joinable()){
+		requested = true;
+		next = input_config;
+		next_buf_size = buf_size;
+		return;
+	}
+
+	old = std::move(current);
+	old_config = active;
+	start(input_config, buf_size);
+}
+
+void Input_Switcher::start(const Module_Config::Input& input_config, const size_t buf_size){
+	config = input_config;
+	done = false;
+	t_started = std::chrono::steady_clock::now();
+	worker = std::thread([this, buf_size]{
+		TRACE_THREAD("input switch");
+		Realtime::reset("input switch");
+		run(buf_size);
+	});
+}
+
+void Input_Switcher::run(const size_t buf_size){
+	TRACE_SCOPE("Input_Switcher::run");
+	bool stopped = false;
+	try{
+		Buffers::Ptr new_buffers = std::make_shared<Buffers>();
+		new_buffers->bufs.emplace_back(buf_size);
+		if(config.stereo){
+			new_buffers->bufs.emplace_back(buf_size);
+		}
+
+		Input::Ptr new_input = factory(config, new_buffers);
+		try{
+			new_input->start_stream(config);
+		}catch(std::exception&){
+			// the new stream may need the device or port of the old one
+			if(!old) throw;
+			old->stop_stream();
+			stopped = true;
+			new_input->start_stream(config);
+		}
+
+		old.reset();
+		old_buffers.reset();
+		input = std::move(new_input);
+		buffers = std::move(new_buffers);
+	}catch(std::exception& e){
+		error = e.what();
+		if(old && stopped){
+			try{
+				old->start_stream(old_config);
+			}catch(std::exception& restart_error){
+				error += ", restarting the old input failed: " + std::string(restart_error.what());
+			}
+		}
+	}
+	done = true;
+}
+
+bool Input_Switcher::poll(Input::Ptr& current, Buffers::Ptr& current_buffers){
+	if(!worker.joinable() || !done) return false;
+
+	if(requested){
+		// the result is superseded, it replaces the old input without being handed over
+		worker.join();
+		requested = false;
+		if(input){
+			old = std::move(input);
+			old_buffers = std::move(buffers);
+			old_config = config;
+		}else{
+			std::cerr << "Can't switch the input: " << error << std::endl;
+			error.clear();
+		}
+		start(next, next_buf_size);
+		return false;
+	}
+
+	if(input && !input->is_offline() && std::chrono::steady_clock::now() - t_started < HANDOVER_TIMEOUT){
+		// keep showing the old buffers until the new input delivers samples
+		auto lock = buffers->bufs[0].lock();
+		if(buffers->bufs[0].stats.received == 0) return false;
+	}
+
+	worker.join();
+	if(!input){
+		std::cerr << "Can't switch the input: " << error << std::endl;
+		error.clear();
+
+		// keep the old input, its buffers are new if it replaced a switch that wasn't handed over
+		current = std::move(old);
+		active = old_config;
+		if(!old_buffers) return false;
+		current_buffers = std::move(old_buffers);
+		return true;
+	}
+
+	current = std::move(input);
+	current_buffers = std::move(buffers);
+	active = config;
+	std::cout << "Input Buffers: " << current_buffers->bufs.size() << std::endl;
+	return true;
+}
+
+// wait for the worker, its result is kept
+void Input_Switcher::finish(){
+	if(worker.joinable()){
+		worker.join();
+	}
+}
@@ -0,0 +1,85 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Input.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+/*
+	Replaces the input stream in the background. The new input is started on a worker thread
+	with its own buffers, the render thread keeps drawing the old buffers until the new input
+	delivered its first samples. The old input keeps running until the new one started, it is
+	only stopped early if the new one fails to start next to it, e.g. because both need the same
+	device or port. If the new input can't be started the old one is kept.
+*/
+class Input_Switcher {
+	public:
+		// creates and configures an input writing into the given buffers
+		using Factory = std::function<Input::Ptr(const Module_Config::Input&, Buffers::Ptr&)>;
+
+		// active is the configuration of the running input
+		Input_Switcher(const Module_Config::Input& active, const Factory& f): factory(f), active(active){};
+		~Input_Switcher();
+
+		// take over the current input and start switching to the new configuration, never blocks
+		// during a switch in progress the newest configuration is started once it finished
+		void request(const Module_Config::Input&, const size_t buf_size, Input::Ptr&);
+
+		// hand over the new input and its buffers once they are ready, returns false if the buffers didn't change
+		// after a failed switch the old input is handed back
+		bool poll(Input::Ptr&, Buffers::Ptr&);
+		// a switch has been requested and not handed over yet
+		bool pending() const { return worker.joinable(); };
+
+		// configuration of the input handed over by the last poll
+		const Module_Config::Input& current() const { return active; };
+
+	private:
+		Factory factory;
+		std::thread worker;
+		std::atomic<bool> done{false};
+		std::chrono::steady_clock::time_point t_started;
+		// configuration of the input the render thread uses
+		Module_Config::Input active;
+
+		// configuration requested during the running switch
+		bool requested = false;
+		Module_Config::Input next;
+		size_t next_buf_size = 0;
+
+		// the replaced input and its configuration, its buffers are only set if they haven't been handed over yet
+		Input::Ptr old;
+		Module_Config::Input old_config;
+		Buffers::Ptr old_buffers;
+
+		// requested configuration and results of the worker, only accessed after done has been set
+		Module_Config::Input config;
+		Input::Ptr input;
+		Buffers::Ptr buffers;
+		std::string error;
+
+		void start(const Module_Config::Input&, const size_t);
+		void run(const size_t);
+		void finish();
+};
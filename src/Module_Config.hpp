@@ -21,10 +21,23 @@
 
 #include <string>
 #include <tuple>
+#include <algorithm>
 #include "Utils.hpp"
 
 namespace Module_Config {
-	enum class Source {FIFO, PULSE};
+	enum class Source {FIFO, PULSE, FILE, REPLAY, SHM, UDP, RTP, ALSA};
+
+	// scheduling of a thread, see Realtime::apply
+	struct Thread {
+		enum class Policy {OTHER, FIFO, RR};
+		Policy policy = Policy::OTHER;
+		int priority = 10;
+		std::string cpus = ""; // cpu list like "0-1,3", empty uses the affinity of the process at startup
+
+		inline bool operator==(const Thread& rhs) const{
+			return std::tie(policy, priority, cpus) == std::tie(rhs.policy, rhs.priority, rhs.cpus);
+		}
+	};
 
 	struct Input {
 		Source source = Source::PULSE;
@@ -33,27 +46,69 @@ namespace Module_Config {
 		bool stereo = false;
 		long long f_sample = 44100;
 		long long latency = 1100; // f_sample * s_latency(0.025 s)
-
+		// record the blocks of realtime inputs to this file
+		std::string record = "";
+		// replay recordings with their original timing, otherwise frame by frame as fast as possible
+		bool realtime = true;
+		// network inputs
+		long long port = 5004;
+		bool l24 = false; // 24 bit instead of 16 bit payload
+		// alsa period size in frames
+		long long period = 256;
+		// scheduling of the capture thread
+		Thread thread;
+
+		// a changed record file doesn't restart the input, realtime only matters for replays
 		inline bool operator==(const Input& rhs) const{
-			return std::tie(source, stereo, f_sample)
-				== std::tie(rhs.source, rhs.stereo, rhs.f_sample);
+			return std::tie(source, file, device, stereo, f_sample, latency, port, l24, period, thread)
+				== std::tie(rhs.source, rhs.file, rhs.device, rhs.stereo, rhs.f_sample, rhs.latency, rhs.port, rhs.l24, rhs.period, rhs.thread)
+				&& (source != Source::REPLAY || realtime == rhs.realtime);
 		}
 	};
 
+	// headless frame output
+	struct Output {
+		// "-" writes raw RGBA frames to stdout, file names ending in .png need one %d (e.g. %06d) for the frame number
+		std::string file = "-";
+		long long frames = 0; // number of frames to render, 0 renders until the program is stopped
+	};
+
 	struct FFT {
 		long long size = 1<<12;
 		size_t output_size = size/2+1;
 		float scale = 2.76678e-08;
 		float d_freq = 44100./(float) size;
+
+		inline bool operator==(const FFT& rhs) const{
+			return std::tie(size, output_size, scale, d_freq) == std::tie(rhs.size, rhs.output_size, rhs.scale, rhs.d_freq);
+		}
+	};
+
+	// analysis of a channel at f_sample / factor, see Decimator
+	struct Decimation {
+		int channel = 0;
+		unsigned factor = 1;
+
+		inline bool operator==(const Decimation& rhs) const{
+			return std::tie(channel, factor) == std::tie(rhs.channel, rhs.factor);
+		}
 	};
 
 	struct Transformation {
 		float Xmin = -1, Xmax = 1, Ymin = -1, Ymax = 1;
+
+		inline bool operator==(const Transformation& rhs) const{
+			return std::tie(Xmin, Xmax, Ymin, Ymax) == std::tie(rhs.Xmin, rhs.Xmax, rhs.Ymin, rhs.Ymax);
+		}
 	};
 
 	struct Color {
 		float rgba[4];
 
+		inline bool operator==(const Color& rhs) const{
+			return std::equal(rgba, rgba + 4, rhs.rgba);
+		}
+
 		inline void normalize(const Color& c){
 			std::copy(c.rgba, c.rgba + 4, rgba);
 			normalize();
@@ -74,6 +129,11 @@ namespace Module_Config {
 		float sigma_coeff = 2;
 		Color color = {1, 1, 1, 1};
 		Transformation pos;
+
+		inline bool operator==(const Oscilloscope& rhs) const{
+			return std::tie(channel, scale, width, sigma, sigma_coeff, color, pos)
+				== std::tie(rhs.channel, rhs.scale, rhs.width, rhs.sigma, rhs.sigma_coeff, rhs.color, rhs.pos);
+		}
 	};
 
 	struct Spectrum {
@@ -84,6 +144,8 @@ namespace Module_Config {
 		float offset = 1.0;
 		int output_size = 100;
 		int data_offset = 0;
+		// index into Config::decimation, the full rate fft of the channel is used if negative
+		int stream = -1;
 		float log_start = 5;
 		float log_enabled = 0;
 
@@ -100,6 +162,13 @@ namespace Module_Config {
 		Color phase_d = {0, 0, 0, 1};
 		bool dB_lines = false;
 
+		inline bool operator==(const Spectrum& rhs) const{
+			return std::tie(channel, min_db, max_db, scale, slope, offset, output_size, data_offset, stream, log_start, log_enabled)
+				== std::tie(rhs.channel, rhs.min_db, rhs.max_db, rhs.scale, rhs.slope, rhs.offset, rhs.output_size, rhs.data_offset, rhs.stream, rhs.log_start, rhs.log_enabled)
+				&& std::tie(top_color, bot_color, line_color, pos, gradient, gravity, bar_width, rainbow, freq_d, phase_d, dB_lines)
+				== std::tie(rhs.top_color, rhs.bot_color, rhs.line_color, rhs.pos, rhs.gradient, rhs.gravity, rhs.bar_width, rhs.rainbow, rhs.freq_d, rhs.phase_d, rhs.dB_lines);
+		}
+
 		void calculate_slope_offset(const float max_db, const float min_db){
 			constexpr float norm = 0.05; // 1/20
 			constexpr float out_max = 1.0;
@@ -46,6 +46,14 @@ namespace GL{
 				FBO::unbind();
 				};
 			inline void blit(const int w, const int h){ blit(w, h, w, h); };
+			// resolve into an offscreen framebuffer
+			inline void blit(const int w, const int h, const FBO& target){
+				fbms(GL_READ_FRAMEBUFFER);
+				target(GL_DRAW_FRAMEBUFFER);
+				glBlitFramebuffer(0, 0, w, h, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+				FBO::unbind();
+				};
 
 			void resize(const int nsamples, const int w, const int h){
 				if(samples > 0){
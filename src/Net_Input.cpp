@@ -0,0 +1,360 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Net_Input.hpp"
+#include "Trace.hpp"
+#include "Realtime.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// jitter buffer capacity in packets
+static const size_t SLOTS = 256;
+// packets received per recvmmsg call
+static const unsigned BATCH = 32;
+static const size_t MAX_PACKET = 4096;
+// buffered packets are released if the stream stalls this long (ms)
+static const int IDLE_TIMEOUT = 100;
+// extended sequence number of the first packet, leaves room for reordered packets
+static const uint64_t SEQ_BASE = uint64_t(1) << 32;
+
+static inline uint16_t be16(const uint8_t* p){
+	return p[0] << 8 | p[1];
+}
+
+static inline uint32_t be32(const uint8_t* p){
+	return uint32_t(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+Net_Input::~Net_Input(){
+	stop_stream();
+}
+
+void Net_Input::start_stream(const Module_Config::Input& input_config){
+	stop_stream();
+
+	rtp = input_config.source == Module_Config::Source::RTP;
+	l24 = input_config.l24;
+	channels = input_config.stereo ? 2 : 1;
+	f_sample = input_config.f_sample;
+	latency = input_config.latency;
+
+	slots.assign(SLOTS, Packet());
+	synced = false;
+	jitter = 0;
+	received = lost = reordered = late = invalid = foreign = 0;
+	jitter_ms = 0;
+	wakeup.reset();
+
+	if(input_config.port <= 0 || input_config.port > 65535){
+		throw std::runtime_error("Invalid UDP port " + std::to_string(input_config.port) + "!");
+	}
+
+	sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(sock < 0) throw std::runtime_error("Can't create UDP socket: " + std::string(std::strerror(errno)));
+
+	int one = 1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one));
+
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(input_config.port);
+	if(bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0){
+		std::string error = std::strerror(errno);
+		stop_stream();
+		throw std::runtime_error("Can't bind UDP port " + std::to_string(input_config.port) + ": " + error);
+	}
+
+	stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(stop_fd < 0){
+		stop_stream();
+		throw std::runtime_error("Can't create network input eventfd: " + std::string(std::strerror(errno)));
+	}
+
+	Module_Config::Thread sched = input_config.thread;
+	thread = std::thread([this, sched]{
+		TRACE_THREAD("net");
+		Realtime::apply(sched, "net");
+		run();
+	});
+}
+
+void Net_Input::stop_stream(){
+	if(thread.joinable()){
+		// wake up the receiver
+		uint64_t one = 1;
+		if(write(stop_fd, &one, sizeof(one)) < 0){
+			std::cerr << "Can't stop the network input!" << std::endl;
+		}
+		thread.join();
+	}
+
+	if(stop_fd >= 0){
+		close(stop_fd);
+		stop_fd = -1;
+	}
+	if(sock >= 0){
+		close(sock);
+		sock = -1;
+	}
+}
+
+void Net_Input::report(std::ostream& os) const{
+	const std::ios_base::fmtflags flags = os.flags();
+	const std::streamsize precision = os.precision();
+	os << "network: " << received << " packets received, " << lost << " lost, " << reordered << " reordered, "
+	   << late << " late or duplicate, " << invalid << " invalid, " << foreign << " from other senders, jitter "
+	   << std::fixed << std::setprecision(2) << jitter_ms << "ms" << std::endl;
+	os.flags(flags);
+	os.precision(precision);
+	wakeup.report(os, "network");
+}
+
+void Net_Input::run(){
+	std::vector<uint8_t> data(BATCH * MAX_PACKET);
+	std::vector<iovec> iov(BATCH);
+	std::vector<mmsghdr> msgs(BATCH);
+	const size_t control_size = CMSG_SPACE(sizeof(timespec));
+	std::vector<char> control(BATCH * control_size);
+	std::vector<sockaddr_in> addrs(BATCH);
+	for(unsigned i = 0; i < BATCH; i++){
+		iov[i] = {data.data() + i * MAX_PACKET, MAX_PACKET};
+		msgs[i] = {};
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_control = control.data() + i * control_size;
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+	}
+
+	pollfd fds[] = {{sock, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+	while(true){
+		int ready = poll(fds, 2, IDLE_TIMEOUT);
+		if(ready < 0){
+			if(errno == EINTR) continue;
+			std::cerr << "Network input poll failed: " << std::strerror(errno) << std::endl;
+			break;
+		}
+		if(fds[1].revents) break;
+
+		if(ready == 0){
+			// the stream stalled, don't hold back the packets after a gap
+			std::lock_guard<std::mutex> lock(buffers->mut);
+			release(true);
+			continue;
+		}
+
+		for(mmsghdr& msg : msgs){
+			msg.msg_hdr.msg_controllen = control_size;
+			msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		}
+		int n = recvmmsg(sock, msgs.data(), BATCH, MSG_DONTWAIT, nullptr);
+		if(n < 0){
+			if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+			std::cerr << "Network input receive failed: " << std::strerror(errno) << std::endl;
+			break;
+		}
+		auto t_arrival = Buffers::clock::now();
+		record_wakeup(msgs[0].msg_hdr);
+
+		TRACE_SCOPE("Net_Input::receive");
+		std::unique_lock<std::mutex> lock(buffers->mut, std::defer_lock);
+		{
+			TRACE_SCOPE("lock Buffers::mut");
+			lock.lock();
+		}
+		for(int i = 0; i < n; i++){
+			if(msgs[i].msg_hdr.msg_flags & MSG_TRUNC){
+				invalid++;
+				continue;
+			}
+			const uint64_t address = uint64_t(ntohl(addrs[i].sin_addr.s_addr)) << 16 | ntohs(addrs[i].sin_port);
+			receive(data.data() + i * MAX_PACKET, msgs[i].msg_len, address, t_arrival);
+		}
+		release(false);
+	}
+}
+
+// time between the arrival of the oldest packet and the receiver running
+void Net_Input::record_wakeup(msghdr& msg){
+	for(cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)){
+		if(c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS){
+			timespec ts, now;
+			std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+			clock_gettime(CLOCK_REALTIME, &now);
+			wakeup.add((now.tv_sec - ts.tv_sec) + (now.tv_nsec - ts.tv_nsec) * 1e-9f);
+		}
+	}
+}
+
+// parse a packet and insert it into the jitter buffer
+void Net_Input::receive(const uint8_t* packet, size_t length, const uint64_t address, const Buffers::clock::time_point t_arrival){
+	received++;
+
+	uint32_t seq, ts;
+	uint64_t sender = address;
+	size_t header;
+	if(rtp){
+		// RFC 3550 5.1
+		if(length < 12 || packet[0] >> 6 != 2){
+			invalid++;
+			return;
+		}
+		header = 12 + 4 * (packet[0] & 0x0f);
+		if(packet[0] & 0x10){
+			// header extension
+			if(header + 4 > length){
+				invalid++;
+				return;
+			}
+			header += 4 + 4 * be16(packet + header + 2);
+		}
+		if(packet[0] & 0x20){
+			// padding, the last octet contains the count
+			length -= std::min<size_t>(packet[length - 1], length);
+		}
+		seq = be16(packet + 2);
+		ts = be32(packet + 4);
+		sender = be32(packet + 8);
+	}else{
+		header = 8;
+		seq = be32(packet);
+		ts = be32(packet + 4);
+	}
+
+	const size_t frame_size = (l24 ? 3 : 2) * channels;
+	if(header >= length || (length - header) % frame_size != 0){
+		invalid++;
+		return;
+	}
+
+	if(synced && sender != source){
+		// another sender, only accepted once the current one went silent
+		if(t_arrival - t_source < std::chrono::milliseconds(IDLE_TIMEOUT)){
+			foreign++;
+			return;
+		}
+		release(true);
+		for(Packet& p : slots) p.valid = false;
+		synced = false;
+	}
+	source = sender;
+	t_source = t_arrival;
+
+	// interarrival jitter in timestamp units
+	const double arrival = std::chrono::duration<double>(t_arrival.time_since_epoch()).count() * f_sample;
+	if(synced){
+		double d = (arrival - last_arrival) - static_cast<int32_t>(ts - last_ts);
+		jitter += (std::abs(d) - jitter) / 16;
+		jitter_ms = jitter * 1000 / f_sample;
+	}
+	last_arrival = arrival;
+	last_ts = ts;
+
+	if(!synced){
+		synced = true;
+		next_seq = highest = SEQ_BASE;
+		last_seq = seq;
+	}
+
+	// extend the sequence number relative to the highest one received so far
+	int64_t delta = rtp ? static_cast<int16_t>(seq - last_seq) : static_cast<int32_t>(seq - last_seq);
+	uint64_t ext = highest + delta;
+
+	if(ext + 4 * SLOTS < next_seq || ext >= next_seq + 4 * SLOTS){
+		// the sender restarted, drop the buffered packets
+		for(Packet& p : slots) p.valid = false;
+		next_seq = highest = ext;
+		last_seq = seq;
+	}else if(ext < next_seq){
+		late++;
+		return;
+	}
+	while(ext >= next_seq + SLOTS){
+		// no space left, give up on the oldest packet
+		Packet& p = slots[next_seq % SLOTS];
+		if(p.valid && p.seq == next_seq){
+			buffers->ingest(p.samples.data(), p.samples.size(), p.t_arrival);
+			p.valid = false;
+		}else{
+			lost++;
+		}
+		next_seq++;
+	}
+
+	if(ext < highest){
+		reordered++;
+	}else{
+		highest = ext;
+		last_seq = seq;
+	}
+
+	Packet& p = slots[ext % SLOTS];
+	if(p.valid && p.seq == ext){
+		late++;
+		return;
+	}
+	store(p, ext, packet + header, length - header, t_arrival);
+}
+
+// convert the big endian payload to 16 bit samples
+void Net_Input::store(Packet& p, const uint64_t seq, const uint8_t* payload, const size_t length, const Buffers::clock::time_point t_arrival){
+	const size_t sample_size = l24 ? 3 : 2;
+	const size_t n = length / sample_size;
+
+	p.valid = true;
+	p.seq = seq;
+	p.t_arrival = t_arrival;
+	p.samples.resize(n);
+	for(size_t i = 0; i < n; i++){
+		// L24 is truncated to the 16 most significant bits
+		p.samples[i] = static_cast<int16_t>(be16(payload + i * sample_size));
+	}
+	packet_frames = std::max<size_t>(n / channels, 1);
+}
+
+// ingest the packets in sequence order, missing ones are skipped once enough later packets arrived
+void Net_Input::release(const bool flush){
+	if(!synced) return;
+
+	const uint64_t depth = std::max<uint64_t>(latency / packet_frames, 1);
+	while(next_seq <= highest){
+		Packet& p = slots[next_seq % SLOTS];
+		if(p.valid && p.seq == next_seq){
+			buffers->ingest(p.samples.data(), p.samples.size(), p.t_arrival);
+			p.valid = false;
+		}else if(flush || highest - next_seq >= depth){
+			lost++;
+		}else{
+			break;
+		}
+		next_seq++;
+	}
+}
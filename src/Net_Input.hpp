@@ -0,0 +1,95 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Input.hpp"
+#include "Realtime.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+
+/*
+	Receives PCM over UDP, either as RTP (RFC 3550) with L16 or L24 payload (RFC 3551)
+	or with a simple framing of a 32 bit sequence number and a 32 bit sample timestamp
+	in front of the payload. All values are big endian, the payload contains interleaved frames.
+
+	Packets are reordered in a jitter buffer that holds up to Input.latency samples
+	before a missing packet is declared lost.
+
+	The input locks onto the first sender, identified by the RTP SSRC or the source address
+	of the simple framing. Packets of other senders are rejected until the current one
+	has been silent for a while.
+*/
+class Net_Input : public Input{
+public:
+	explicit Net_Input(Buffers::Ptr& buffers) : buffers(buffers){};
+
+	~Net_Input() override;
+
+	void start_stream(const Module_Config::Input&) override;
+
+	void stop_stream() override;
+
+	void report(std::ostream&) const override;
+
+private:
+	struct Packet {
+		bool valid = false;
+		uint64_t seq;
+		Buffers::clock::time_point t_arrival;
+		std::vector<int16_t> samples;
+	};
+
+	Buffers::Ptr buffers;
+	bool rtp = true, l24 = false;
+	unsigned channels = 1;
+	long long f_sample = 44100, latency = 1100;
+
+	int sock = -1;
+	int stop_fd = -1;
+	std::thread thread;
+
+	// jitter buffer
+	std::vector<Packet> slots;
+	bool synced = false;
+	uint64_t next_seq = 0, highest = 0; // extended sequence numbers
+	uint32_t last_seq = 0; // last received sequence number
+	size_t packet_frames = 1;
+	// current sender and the arrival of its last packet
+	uint64_t source = 0;
+	Buffers::clock::time_point t_source;
+
+	// interarrival jitter in samples (RFC 3550 A.8)
+	double jitter = 0;
+	double last_arrival = 0;
+	uint32_t last_ts = 0;
+
+	std::atomic<uint64_t> received{0}, lost{0}, reordered{0}, late{0}, invalid{0}, foreign{0};
+	std::atomic<float> jitter_ms{0};
+	// kernel receive timestamp of the first packet until the receiver runs
+	Realtime::Wakeup_Stats wakeup;
+
+	void run();
+	void record_wakeup(msghdr&);
+	void receive(const uint8_t*, size_t, const uint64_t address, const Buffers::clock::time_point);
+	void store(Packet&, const uint64_t, const uint8_t*, const size_t, const Buffers::clock::time_point);
+	void release(const bool flush);
+};
@@ -18,6 +18,9 @@
  */
 
 #include "Oscilloscope.hpp"
+#include "Program_Cache.hpp"
+#include "Profiler.hpp"
+#include "Trace.hpp"
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
@@ -26,18 +29,32 @@
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
 
-Oscilloscope::Oscilloscope(const Module_Config::Oscilloscope& config, const unsigned o_id): size(0), id(o_id){
+Oscilloscope::Oscilloscope(){
 	init_crt();
+	st_draw = GL::Profiler::get().stage("oscilloscopes");
 
-	configure(config);
+	// every instance binds its own range of the parameter buffer
+	param_stride = Uniforms::aligned_size(sizeof(Uniforms::Oscilloscope));
 }
 
 void Oscilloscope::draw(){
+	TRACE_SCOPE("Oscilloscope::draw");
+	if(instances.empty()) return;
+
+	GL::Profiler::get().begin(st_draw);
 	sh_crt.use();
-	v_crt.bind();
+	for(size_t i = 0; i < instances.size(); i++){
+		const Channel& c = channels[instances[i].channel];
+		if(c.size == 0) continue;
 
-	glDrawArrays(GL_LINE_STRIP, 0, size);
+		b_params.ubobind(Uniforms::MODULE, i * param_stride, sizeof(Uniforms::Oscilloscope));
+		c.vao.bind();
+		glDrawArrays(GL_LINE_STRIP, 0, c.size);
+	}
+	GL::VAO::unbind();
+	GL::Profiler::get().end();
 }
 
 void Oscilloscope::init_crt(){
@@ -45,94 +62,149 @@ void Oscilloscope::init_crt(){
 	#include "shader/osc.vert"
 	;
 
-	GL::Shader vert(vert_code, GL_VERTEX_SHADER);
-
 	const char* geom_code =
 	#include "shader/osc.geom"
 	;
 
-	GL::Shader geom(geom_code, GL_GEOMETRY_SHADER);
-
 	const char* frag_code =
 	#include "shader/osc.frag"
 	;
 
-	GL::Shader frag(frag_code, GL_FRAGMENT_SHADER);
-
 	try{
-		sh_crt.link(vert, geom, frag);
+		GL::Program_Cache::get().link(sh_crt, {{vert_code, GL_VERTEX_SHADER}, {geom_code, GL_GEOMETRY_SHADER}, {frag_code, GL_FRAGMENT_SHADER}});
+
+		sh_crt.bind_uniform_block("Oscilloscope_Params", Uniforms::MODULE);
+		sh_crt.bind_uniform_block("Frame", Uniforms::FRAME);
 	}
 	catch(std::invalid_argument& e){
 		std::cerr << "Can't link oscilloscope shader!" << std::endl << e.what() << std::endl;
 	}
 
-	v_crt.bind();
-
-	b_crt_y.bind();
 	GLint arg_y = sh_crt.get_attrib("y");
-	glVertexAttribPointer(arg_y, 1, GL_SHORT, GL_FALSE, 0, nullptr);
-	glEnableVertexAttribArray(arg_y);
+	for(Channel& c : channels){
+		c.vao.bind();
+
+		c.samples.bind();
+		glVertexAttribPointer(arg_y, 1, GL_SHORT, GL_FALSE, 0, nullptr);
+		glEnableVertexAttribArray(arg_y);
+	}
 
 	GL::VAO::unbind();
 }
 
-void Oscilloscope::configure(const Module_Config::Oscilloscope& ocfg){
-	sh_crt();
+void Oscilloscope::configure(const std::vector<Module_Config::Oscilloscope>& ocfgs){
+	size_t count = ocfgs.size();
+	size_t old_count = instances.size();
+	instances.resize(count);
 
-	GLint i_scale = sh_crt.get_uniform("scale");
-	glUniform1f(i_scale, ocfg.scale/32768.0);
+	// range of parameter blocks that have to be uploaded
+	size_t first = count, last = 0;
+	for(size_t i = 0; i < count; i++){
+		Instance& inst = instances[i];
+		if(i < old_count && inst.config == ocfgs[i]) continue;
 
-	GLint i_color = sh_crt.get_uniform("line_color");
-	glUniform4fv(i_color, 1, ocfg.color.rgba);
-
-	GLint i_width = sh_crt.get_uniform("width");
-	glUniform1f(i_width, ocfg.width);
+		set_params(inst, ocfgs[i]);
+		first = std::min(first, i);
+		last = i + 1;
+	}
 
-	GLint i_sigma = sh_crt.get_uniform("sigma");
-	glUniform1f(i_sigma, ocfg.sigma);
+	// grow the parameter buffer, all blocks have to be uploaded again
+	if(count > param_instances){
+		param_instances = count;
+		b_params.bind(GL_UNIFORM_BUFFER);
+		glBufferData(GL_UNIFORM_BUFFER, param_instances * param_stride, nullptr, GL_DYNAMIC_DRAW);
+		GL::Buffer::unbind(GL_UNIFORM_BUFFER);
+		first = 0;
+		last = count;
+	}
+	upload_params(first, last);
+}
 
-	GLint i_sigma_c = sh_crt.get_uniform("sigma_coeff");
-	glUniform1f(i_sigma_c, ocfg.sigma_coeff);
+void Oscilloscope::set_params(Instance& inst, const Module_Config::Oscilloscope& ocfg){
+	inst.config = ocfg;
+	inst.channel = 0;
 
-	set_transformation(ocfg.pos);
+	Uniforms::Oscilloscope& params = inst.params;
+	params.scale = ocfg.scale/32768.0;
+	std::copy(ocfg.color.rgba, ocfg.color.rgba + 4, params.line_color);
+	params.width = ocfg.width;
+	params.sigma = ocfg.sigma;
+	params.sigma_coeff = ocfg.sigma_coeff;
+	// set by update_buffer once the channel has been uploaded
+	params.length_1 = 0;
 
-	channel = ocfg.channel;
+	set_transformation(params, ocfg.pos);
 }
 
-void Oscilloscope::resize_x_buffer(const size_t size){
-	sh_crt();
-	GLint i_length = sh_crt.get_uniform("length_1");
-	glUniform1f(i_length, 1./size);
+// upload the parameters of the instances [first, last)
+void Oscilloscope::upload_params(const size_t first, const size_t last){
+	if(first >= last) return;
+
+	b_params.bind(GL_UNIFORM_BUFFER);
+	for(size_t i = first; i < last; i++){
+		glBufferSubData(GL_UNIFORM_BUFFER, i * param_stride, sizeof(Uniforms::Oscilloscope), &instances[i].params);
+	}
+	GL::Buffer::unbind(GL_UNIFORM_BUFFER);
 }
 
-void Oscilloscope::set_transformation(const Module_Config::Transformation& t){
+void Oscilloscope::set_transformation(Uniforms::Oscilloscope& params, const Module_Config::Transformation& t){
 	glm::mat4 transformation = glm::ortho(t.Xmin, t.Xmax, t.Ymin, t.Ymax);
-
-	sh_crt();
-
-	GLint i_trans = sh_crt.get_uniform("trans");
-	glUniformMatrix4fv(i_trans, 1, GL_FALSE, glm::value_ptr(transformation));
+	const float* trans = glm::value_ptr(transformation);
+	std::copy(trans, trans + 16, params.trans);
 }
 
-void Oscilloscope::update_buffer(Buffer<int16_t>& buffer){
+// returns true if new data has been uploaded
+bool Oscilloscope::upload(Channel& c, Buffer<int16_t>& buffer){
 	auto lock = buffer.lock();
-	// resize x coordinate buffer if necessary
-	if(size != buffer.size){
-		size = buffer.size;
-		resize_x_buffer(size);
+	if(c.size != buffer.size){
+		c.size = buffer.size;
 
-		b_crt_y.bind();
-		glBufferData(GL_ARRAY_BUFFER, size * sizeof(int16_t), &buffer.v_buffer[0], GL_DYNAMIC_DRAW);
+		c.samples.bind();
+		glBufferData(GL_ARRAY_BUFFER, c.size * sizeof(int16_t), &buffer.v_buffer[0], GL_DYNAMIC_DRAW);
 	}else{
-		b_crt_y.bind();
-		glBufferSubData(GL_ARRAY_BUFFER, 0, size * sizeof(int16_t), &buffer.v_buffer[0]);
+		// skip the upload if the buffer hasn't changed
+		if(c.seq == buffer.seq) return false;
+
+		c.samples.bind();
+		glBufferSubData(GL_ARRAY_BUFFER, 0, c.size * sizeof(int16_t), &buffer.v_buffer[0]);
 	}
+	c.seq = buffer.seq;
+	t_capture = std::max(t_capture, buffer.t_capture);
+	return true;
 }
 
-void Oscilloscope::update_buffer(std::vector<Buffer<int16_t>>& buffers){
-	if(buffers.size() > channel){
-		update_buffer(buffers[channel]);
-	}else{
-		update_buffer(buffers[0]);
+bool Oscilloscope::update_buffer(std::vector<Buffer<int16_t>>& buffers){
+	TRACE_SCOPE("Oscilloscope::update_buffer");
+	if(instances.empty() || buffers.empty()) return false;
+
+	// resolve the channel of every instance, mono inputs only have the first one
+	std::array<bool, 2> used = {false, false};
+	size_t first = instances.size(), last = 0;
+	for(size_t i = 0; i < instances.size(); i++){
+		Instance& inst = instances[i];
+		unsigned channel = std::max(inst.config.channel, 0);
+		inst.channel = channel < std::min<size_t>(buffers.size(), channels.size()) ? channel : 0;
+		used[inst.channel] = true;
+	}
+
+	bool uploaded = false;
+	for(size_t c = 0; c < channels.size(); c++){
+		if(used[c]){
+			uploaded |= upload(channels[c], buffers[c]);
+		}
 	}
+
+	// the x coordinates depend on the length of the shown channel
+	for(size_t i = 0; i < instances.size(); i++){
+		Instance& inst = instances[i];
+		float length_1 = 1./std::max<size_t>(channels[inst.channel].size, 1);
+		if(inst.params.length_1 != length_1){
+			inst.params.length_1 = length_1;
+			first = std::min(first, i);
+			last = i + 1;
+		}
+	}
+	upload_params(first, last);
+
+	return uploaded;
 }
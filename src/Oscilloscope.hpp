@@ -22,10 +22,14 @@
 #include "Buffer.hpp"
 #include "Module_Config.hpp"
 #include "GL_utils.hpp"
+#include "Uniforms.hpp"
+#include <array>
+#include <vector>
 
+// batched renderer for all oscilloscope instances, the samples of a channel are uploaded once and shared by its instances
 class Oscilloscope {
 	public:
-		Oscilloscope(const Module_Config::Oscilloscope&, const unsigned);
+		Oscilloscope();
 		// disable copy construction
 		Oscilloscope(const Oscilloscope&) = delete;
 		Oscilloscope(Oscilloscope&&) = default;
@@ -33,18 +37,39 @@ class Oscilloscope {
 		~Oscilloscope(){};
 
 		void draw();
-		void update_buffer(Buffer<int16_t>&);
-		void update_buffer(std::vector<Buffer<int16_t>>&);
-		void configure(const Module_Config::Oscilloscope&);
+		// upload the channels shown by any instance, returns true if new data has been uploaded
+		bool update_buffer(std::vector<Buffer<int16_t>>&);
+		void configure(const std::vector<Module_Config::Oscilloscope>&);
+		// capture time of the newest uploaded sample
+		Buffer<int16_t>::clock::time_point captured() const { return t_capture; };
 
 	private:
+		// uploaded samples of an input channel
+		struct Channel {
+			GL::VAO vao;
+			GL::Buffer samples;
+			size_t size = 0;
+			uint64_t seq = 0; // sequence number of the uploaded buffer
+		};
+
+		struct Instance {
+			unsigned channel = 0; // channel of the input buffers, falls back to the first one
+			Module_Config::Oscilloscope config; // last applied configuration
+			Uniforms::Oscilloscope params;
+		};
+
 		GL::Program sh_crt;
-		GL::VAO v_crt;
-		GL::Buffer b_crt_y;
-		size_t size;
-		unsigned id, channel;
+		GL::Buffer b_params;
+		std::array<Channel, 2> channels;
+		std::vector<Instance> instances;
+		GLsizeiptr param_stride; // aligned size of the parameters of an instance
+		size_t param_instances = 0; // instances allocated in b_params
+		Buffer<int16_t>::clock::time_point t_capture;
+		unsigned st_draw; // profiler stage
 
 		void init_crt();
-		void resize_x_buffer(const size_t);
-		void set_transformation(const Module_Config::Transformation&);
+		bool upload(Channel&, Buffer<int16_t>&);
+		void upload_params(const size_t first, const size_t last);
+		void set_params(Instance&, const Module_Config::Oscilloscope&);
+		void set_transformation(Uniforms::Oscilloscope&, const Module_Config::Transformation&);
 };
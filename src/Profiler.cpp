@@ -0,0 +1,108 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Profiler.hpp"
+#include <iomanip>
+
+using namespace GL;
+
+Profiler& Profiler::get(){
+	static Profiler profiler;
+	return profiler;
+}
+
+unsigned Profiler::stage(const std::string& name){
+	for(unsigned i = 0; i < stages.size(); i++){
+		if(stages[i].name == name) return i;
+	}
+
+	stages.emplace_back();
+	stages.back().name = name;
+	return stages.size() - 1;
+}
+
+// accumulate the result of a previous frame, skip it if it isn't available yet
+void Profiler::collect(Stage& s, const unsigned i){
+	if(!s.issued[i]) return;
+	s.issued[i] = false;
+
+	GLint available = 0;
+	glGetQueryObjectiv(s.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+	if(!available) return;
+
+	GLuint64 ns = 0;
+	glGetQueryObjectui64v(s.queries[i], GL_QUERY_RESULT, &ns);
+	s.gpu_time += ns * 1e-9;
+	s.gpu_samples++;
+}
+
+void Profiler::begin(const unsigned stage){
+	if(!enabled || active >= 0) return;
+
+	Stage& s = stages[stage];
+	if(s.queries[0] == 0){
+		glGenQueries(2, s.queries.data());
+	}
+
+	// the query has been issued two frames ago
+	collect(s, s.next);
+	glBeginQuery(GL_TIME_ELAPSED, s.queries[s.next]);
+	s.issued[s.next] = true;
+	s.next ^= 1;
+
+	active = stage;
+	t_begin = clock::now();
+}
+
+void Profiler::end(){
+	if(active < 0) return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+
+	Stage& s = stages[active];
+	s.cpu_time += std::chrono::duration<double>(clock::now() - t_begin).count();
+	s.cpu_samples++;
+	active = -1;
+}
+
+void Profiler::report(std::ostream& os, const int n){
+	if(++frames < n) return;
+	frames = 0;
+
+	// keep the caller's stream formatting
+	const std::ios_base::fmtflags flags = os.flags();
+	const std::streamsize precision = os.precision();
+	os << std::fixed << std::setprecision(3);
+	double gpu_total = 0, cpu_total = 0;
+	for(Stage& s : stages){
+		if(s.cpu_samples == 0) continue;
+
+		double gpu = s.gpu_samples > 0 ? s.gpu_time / s.gpu_samples * 1000 : 0;
+		double cpu = s.cpu_time / s.cpu_samples * 1000;
+		gpu_total += gpu;
+		cpu_total += cpu;
+		os << "  " << std::setw(24) << std::left << s.name << std::right << " GPU " << gpu << " ms, CPU " << cpu << " ms" << std::endl;
+
+		s.gpu_time = s.cpu_time = 0;
+		s.gpu_samples = s.cpu_samples = 0;
+	}
+	os << "  " << std::setw(24) << std::left << "total" << std::right << " GPU " << gpu_total << " ms, CPU " << cpu_total << " ms" << std::endl;
+	os.flags(flags);
+	os.precision(precision);
+}
@@ -0,0 +1,83 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "GL_utils.hpp"
+#include <array>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace GL {
+	/*!
+		GPU and CPU timings of render stages.
+
+		Every stage uses two GL_TIME_ELAPSED queries in turns, results are only read once they are available.
+		Timer queries can't be nested, stages have to be sequential.
+	*/
+	class Profiler {
+		public:
+			static Profiler& get();
+
+			/*!
+				Register a render stage. Stages with the same name share their timings.
+				\param name stage name
+				\return stage handle
+			*/
+			unsigned stage(const std::string& name);
+
+			//! start timing a stage
+			void begin(const unsigned stage);
+			//! stop timing the current stage
+			void end();
+
+			/*!
+				Print the average GPU and CPU time of every stage after n calls and reset them.
+				\param os output stream
+				\param n report interval
+			*/
+			void report(std::ostream& os, const int n);
+
+			bool enabled = false; //!< disabled profilers don't issue any queries
+
+		private:
+			using clock = std::chrono::steady_clock;
+
+			struct Stage {
+				std::string name;
+				// queries aren't deleted, they live as long as the context
+				std::array<GLuint, 2> queries = {{0, 0}};
+				std::array<bool, 2> issued = {{false, false}};
+				unsigned next = 0;
+
+				double gpu_time = 0, cpu_time = 0;
+				unsigned gpu_samples = 0, cpu_samples = 0;
+			};
+
+			Profiler() = default;
+			void collect(Stage&, const unsigned);
+
+			std::vector<Stage> stages;
+			int active = -1;
+			clock::time_point t_begin;
+			int frames = 0;
+	};
+}
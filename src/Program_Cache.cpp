@@ -0,0 +1,173 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Program_Cache.hpp"
+#include "xdg.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+using namespace GL;
+
+// cache file header
+struct Binary_Header {
+	char magic[4];
+	uint32_t format;
+	uint32_t length;
+};
+
+static const char cache_magic[4] = {'G', 'L', 'M', 'B'};
+
+// 64 bit FNV-1a hash
+static inline void fnv1a(uint64_t& h, const char* data, const size_t n){
+	for(size_t i = 0; i < n; i++){
+		h ^= static_cast<unsigned char>(data[i]);
+		h *= 0x100000001b3ULL;
+	}
+}
+
+static inline void fnv1a(uint64_t& h, const std::string& str){
+	// include the terminating null character to separate strings
+	fnv1a(h, str.c_str(), str.size() + 1);
+}
+
+static std::string gl_string(const GLenum name){
+	const GLubyte* str = glGetString(name);
+	return str ? reinterpret_cast<const char*>(str) : "";
+}
+
+Program_Cache& Program_Cache::get(){
+	static Program_Cache cache;
+	return cache;
+}
+
+void Program_Cache::init(){
+	initialized = true;
+
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if(formats <= 0) return;
+
+	dir = xdg::cache_dir("/GLMViz/shaders");
+	if(dir.empty()) return;
+
+	gl_id = gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' + gl_string(GL_VERSION);
+	supported = true;
+}
+
+std::string Program_Cache::hash(const std::vector<Source>& sources, const std::vector<const char*>& varyings) const{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	fnv1a(h, gl_id);
+	for(const Source& s : sources){
+		fnv1a(h, std::to_string(s.type));
+		fnv1a(h, s.code);
+	}
+	for(const char* v : varyings){
+		fnv1a(h, v);
+	}
+
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << h;
+	return ss.str();
+}
+
+bool Program_Cache::load(Program& p, const std::string& key){
+	std::ifstream file(dir + "/" + key, std::ifstream::binary);
+	if(!file.is_open()) return false;
+
+	Binary_Header header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if(!file || !std::equal(cache_magic, cache_magic + 4, header.magic)) return false;
+
+	// a truncated or corrupt file is a cache miss
+	std::streampos start = file.tellg();
+	file.seekg(0, std::ifstream::end);
+	std::streamoff remaining = file.tellg() - start;
+	file.seekg(start);
+	if(!file || static_cast<std::streamoff>(header.length) != remaining) return false;
+
+	std::vector<char> binary(header.length);
+	file.read(binary.data(), binary.size());
+	if(!file) return false;
+
+	return p.load_binary(header.format, binary);
+}
+
+void Program_Cache::store(const Program& p, const std::string& key){
+	GLenum format;
+	std::vector<char> binary;
+	if(!p.get_binary(format, binary)) return;
+
+	Binary_Header header;
+	std::copy(cache_magic, cache_magic + 4, header.magic);
+	header.format = format;
+	header.length = binary.size();
+
+	// write to a temporary file and rename it to avoid partially written binaries
+	std::string path = dir + "/" + key;
+	std::string tmp_path = path + ".tmp";
+	{
+		std::ofstream file(tmp_path, std::ofstream::binary | std::ofstream::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), binary.size());
+		if(!file) return;
+	}
+	std::rename(tmp_path.c_str(), path.c_str());
+}
+
+void Program_Cache::link(Program& p, const std::vector<Source>& sources, const std::vector<const char*>& varyings){
+	auto t_start = std::chrono::steady_clock::now();
+	if(!initialized) init();
+
+	std::string key;
+	if(supported){
+		key = hash(sources, varyings);
+		if(load(p, key)){
+			hits++;
+			link_time += std::chrono::duration<float>(std::chrono::steady_clock::now() - t_start).count();
+			return;
+		}
+	}
+
+	// fall back to compiling the shaders
+	std::vector<Shader> shaders;
+	shaders.reserve(sources.size());
+	for(const Source& s : sources){
+		shaders.emplace_back(s.code, s.type);
+	}
+
+	if(!varyings.empty()){
+		glTransformFeedbackVaryings(p.get_id(), varyings.size(), varyings.data(), GL_INTERLEAVED_ATTRIBS);
+	}
+	if(supported){
+		glProgramParameteri(p.get_id(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	p.link_vector(shaders);
+	misses++;
+
+	if(supported){
+		store(p, key);
+	}
+	link_time += std::chrono::duration<float>(std::chrono::steady_clock::now() - t_start).count();
+}
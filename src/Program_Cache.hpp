@@ -0,0 +1,68 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "GL_utils.hpp"
+#include <string>
+#include <vector>
+
+namespace GL {
+	/*!
+		On-disk cache of linked shader programs.
+
+		Programs are keyed by their shader sources and the GL vendor, renderer and version strings.
+		Binaries are stored in $XDG_CACHE_HOME/GLMViz/shaders.
+	*/
+	class Program_Cache {
+		public:
+			struct Source {
+				const char* code;
+				GLenum type;
+			};
+
+			static Program_Cache& get();
+
+			/*!
+				Link a program from the given sources, using a cached binary if possible.
+				Throws std::invalid_argument if the shaders can't be compiled or linked.
+				\param p program to link
+				\param sources shader sources
+				\param varyings transform feedback varyings
+			*/
+			void link(Program& p, const std::vector<Source>& sources, const std::vector<const char*>& varyings = {});
+
+			unsigned hits = 0; //!< number of programs loaded from the cache
+			unsigned misses = 0; //!< number of compiled programs
+			float link_time = 0; //!< total time spent linking programs in seconds
+
+		private:
+			Program_Cache() = default;
+
+			void init();
+			std::string hash(const std::vector<Source>&, const std::vector<const char*>&) const;
+			bool load(Program&, const std::string&);
+			void store(const Program&, const std::string&);
+
+			bool initialized = false;
+			bool supported = false;
+			std::string dir;
+			std::string gl_id;
+	};
+}
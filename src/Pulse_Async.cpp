@@ -18,9 +18,12 @@
  */
 
 #include "Pulse_Async.hpp"
+#include "Trace.hpp"
+#include "Realtime.hpp"
 
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 
 
 namespace PA{
@@ -142,6 +145,10 @@ void Pulse_Async::stop_stream(){
 void Pulse_Async::start_stream(const Module_Config::Input& config){
 	PA::Lock lock(mainloop);
 
+	// the mainloop thread is configured by the first read callback
+	thread_config = config.thread;
+	thread_configured = false;
+
 	pa_sample_spec sample_spec = {};
 	sample_spec.format = PA_SAMPLE_S16LE;
 	sample_spec.rate =  (uint32_t) config.f_sample;
@@ -157,6 +164,7 @@ void Pulse_Async::start_stream(const Module_Config::Input& config){
 
 	pa_stream_set_state_callback(stream, stream_state_cb, this);
 	pa_stream_set_read_callback(stream, stream_read_cb, this);
+	pa_stream_set_overflow_callback(stream, stream_overflow_cb, this);
 
 	std::string dev;
 	if(config.device.empty()){
@@ -177,7 +185,9 @@ void Pulse_Async::start_stream(const Module_Config::Input& config){
 	};
 
 
-	if(pa_stream_connect_record(stream, dev.c_str(), &buffer_attr, PA_STREAM_ADJUST_LATENCY) < 0){
+	// keep the latency information up to date for capture timestamps
+	pa_stream_flags_t flags = static_cast<pa_stream_flags_t>(PA_STREAM_ADJUST_LATENCY | PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_INTERPOLATE_TIMING);
+	if(pa_stream_connect_record(stream, dev.c_str(), &buffer_attr, flags) < 0){
 		throw std::runtime_error("Can't connect Audio stream!");
 	}
 
@@ -205,21 +215,39 @@ void Pulse_Async::stream_state_cb(pa_stream* stream, void* userdata){
 	}
 }
 
-// internal read function
-template<typename T>
-static void i_read(std::vector<Buffer<T>>& buffers, T buf[], size_t size){
-	size = size / 2;
-	if(buffers.size() > 1){
-		buffers[0].write_offset(buf, size, 2, 0);
-		buffers[1].write_offset(buf, size, 2, 1);
-	}else{
-		buffers[0].write(buf, size);
+// estimate the capture time of the last sample in a fragment of length bytes at the read index
+static Buffer<int16_t>::clock::time_point capture_time(pa_stream* stream, const size_t length){
+	auto now = Buffer<int16_t>::clock::now();
+
+	// latency of the sample at the read index, includes the source latency
+	pa_usec_t latency;
+	int negative;
+	if(pa_stream_get_latency(stream, &latency, &negative) < 0){
+		return now;
 	}
+
+	// the last sample of the fragment is younger by the fragment length
+	int64_t age = negative ? -static_cast<int64_t>(latency) : latency;
+	age -= pa_bytes_to_usec(length, pa_stream_get_sample_spec(stream));
+	return now - std::chrono::microseconds(std::max<int64_t>(age, 0));
+}
+
+// the server dropped data because the stream hasn't been read fast enough
+void Pulse_Async::stream_overflow_cb(pa_stream* stream, void* userdata){
+	auto* data = reinterpret_cast<Pulse_Async*>(userdata);
+	data->p_buffers->overruns++;
 }
 
 void Pulse_Async::stream_read_cb(pa_stream* stream, size_t len, void* userdata){
+	TRACE_THREAD("pulse");
+	TRACE_SCOPE("Pulse_Async::stream_read_cb");
 	auto* data = reinterpret_cast<Pulse_Async*>(userdata);
 
+	if(!data->thread_configured){
+		data->thread_configured = true;
+		Realtime::apply(data->thread_config, "pulse");
+	}
+
 	while (pa_stream_readable_size(stream)){
 		// read stream buffer
 		int16_t* buf;
@@ -229,8 +257,12 @@ void Pulse_Async::stream_read_cb(pa_stream* stream, size_t len, void* userdata){
 
 		if(buf){
 			// lock buffer vector, read stream buffer into audio buffers
-			std::lock_guard<std::mutex> lock(data->p_buffers->mut);
-			i_read(data->p_buffers->bufs, buf, len);
+			std::unique_lock<std::mutex> lock(data->p_buffers->mut, std::defer_lock);
+			{
+				TRACE_SCOPE("lock Buffers::mut");
+				lock.lock();
+			}
+			data->p_buffers->ingest(buf, len / sizeof(int16_t), capture_time(stream, len));
 		}
 
 		// drop stream buffer
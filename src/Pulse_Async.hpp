@@ -41,7 +41,11 @@ private:
 
 	static void stream_read_cb(pa_stream*, size_t, void*);
 
+	static void stream_overflow_cb(pa_stream*, void*);
+
 	std::string device;
+	Module_Config::Thread thread_config;
+	bool thread_configured = false;
 	pa_threaded_mainloop* mainloop;
 	pa_context* context;
 	Buffers::Ptr p_buffers;
@@ -0,0 +1,170 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Realtime.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace Realtime {
+	// affinity of the process at startup, new threads inherit the affinity of their creator
+	static struct Initial_Affinity {
+		cpu_set_t set;
+		bool valid;
+		Initial_Affinity(){ valid = sched_getaffinity(0, sizeof(set), &set) == 0; };
+	} initial_affinity;
+
+	static void apply_policy(const Module_Config::Thread& t, const std::string& name){
+		if(t.policy == Module_Config::Thread::Policy::OTHER){
+			// leave a realtime policy of an earlier configuration
+			int policy;
+			sched_param param;
+			if(pthread_getschedparam(pthread_self(), &policy, &param) != 0) return;
+			// the policy reported by the kernel includes SCHED_RESET_ON_FORK
+			policy &= ~SCHED_RESET_ON_FORK;
+			if(policy == SCHED_FIFO || policy == SCHED_RR){
+				param.sched_priority = 0;
+				pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+			}
+			return;
+		}
+
+		const int policy = t.policy == Module_Config::Thread::Policy::FIFO ? SCHED_FIFO : SCHED_RR;
+		const char* policy_name = policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR";
+		int priority = std::max(sched_get_priority_min(policy), std::min(t.priority, sched_get_priority_max(policy)));
+
+		// unprivileged processes are limited by RLIMIT_RTPRIO
+		rlimit limit;
+		if(geteuid() != 0 && getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY){
+			if(limit.rlim_cur == 0){
+				std::cerr << name << " thread: RLIMIT_RTPRIO is 0, keeping the default scheduling (raise it with e.g. \"@audio - rtprio 95\" in limits.conf)" << std::endl;
+				return;
+			}
+			if(static_cast<rlim_t>(priority) > limit.rlim_cur){
+				std::cerr << name << " thread: priority " << priority << " exceeds RLIMIT_RTPRIO, using " << limit.rlim_cur << std::endl;
+				priority = limit.rlim_cur;
+			}
+		}
+
+		// children like shader compilers don't inherit the realtime policy
+		sched_param param = {};
+		param.sched_priority = priority;
+		int err = pthread_setschedparam(pthread_self(), policy | SCHED_RESET_ON_FORK, &param);
+		if(err){
+			std::cerr << name << " thread: can't set " << policy_name << ": " << std::strerror(err) << ", keeping the default scheduling" << std::endl;
+			return;
+		}
+		std::cout << name << " thread: " << policy_name << " priority " << priority << std::endl;
+	}
+
+	static void apply_affinity(const Module_Config::Thread& t, const std::string& name){
+		if(t.cpus.empty()){
+			// don't keep the cpus of the creating thread
+			if(initial_affinity.valid) pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &initial_affinity.set);
+			return;
+		}
+
+		cpu_set_t set;
+		if(!parse_cpus(t.cpus, set)){
+			std::cerr << name << " thread: invalid cpu list \"" << t.cpus << "\"" << std::endl;
+			return;
+		}
+		int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		if(err){
+			std::cerr << name << " thread: can't set the affinity to " << t.cpus << ": " << std::strerror(err) << std::endl;
+			return;
+		}
+		std::cout << name << " thread: cpus " << t.cpus << std::endl;
+	}
+
+	void apply(const Module_Config::Thread& t, const std::string& name){
+		apply_affinity(t, name);
+		apply_policy(t, name);
+	}
+
+	bool parse_cpus(const std::string& list, cpu_set_t& set){
+		CPU_ZERO(&set);
+		size_t pos = 0;
+		while(pos < list.size()){
+			size_t end = list.find(',', pos);
+			if(end == std::string::npos) end = list.size();
+			std::string range = list.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t dash = range.find('-');
+			try{
+				size_t used;
+				int first = std::stoi(range, &used);
+				int last = first;
+				if(dash != std::string::npos){
+					if(used != dash) return false;
+					last = std::stoi(range.substr(dash + 1), &used);
+					used += dash + 1;
+				}
+				if(used != range.size() || first < 0 || last < first || last >= CPU_SETSIZE) return false;
+				for(int cpu = first; cpu <= last; cpu++){
+					CPU_SET(cpu, &set);
+				}
+			}catch(std::logic_error&){
+				return false;
+			}
+		}
+		return CPU_COUNT(&set) > 0;
+	}
+
+	void Wakeup_Stats::add(const float seconds){
+		uint32_t us = std::max(seconds, 0.f) * 1e6f;
+		size_t bucket = 0;
+		while(bucket + 1 < BUCKETS && (1u << (bucket + 1)) <= us) bucket++;
+		count[bucket].fetch_add(1, std::memory_order_relaxed);
+
+		uint32_t max = max_us.load(std::memory_order_relaxed);
+		while(us > max && !max_us.compare_exchange_weak(max, us, std::memory_order_relaxed));
+	}
+
+	void Wakeup_Stats::reset(){
+		for(auto& c : count) c = 0;
+		max_us = 0;
+	}
+
+	uint32_t Wakeup_Stats::percentile(const float p, const uint64_t total) const{
+		uint64_t sum = 0;
+		for(size_t i = 0; i < BUCKETS; i++){
+			sum += count[i].load(std::memory_order_relaxed);
+			if(sum >= p * total) return 1u << (i + 1);
+		}
+		return 1u << BUCKETS;
+	}
+
+	void Wakeup_Stats::report(std::ostream& os, const std::string& name) const{
+		uint64_t total = 0;
+		for(auto& c : count) total += c.load(std::memory_order_relaxed);
+		if(total == 0) return;
+
+		os << name << " wakeup latency p50/p99/max: <" << percentile(0.5, total) << "/<" << percentile(0.99, total)
+		   << "/" << max_us.load(std::memory_order_relaxed) << " us (" << total << " wakeups)" << std::endl;
+	}
+}
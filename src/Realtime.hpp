@@ -0,0 +1,55 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <ostream>
+#include <sched.h>
+#include "Module_Config.hpp"
+
+namespace Realtime {
+	// apply the scheduling policy and cpu affinity to the calling thread,
+	// settings that aren't permitted are reported and the thread keeps its current ones
+	void apply(const Module_Config::Thread&, const std::string& name);
+
+	// threads inherit the policy and affinity of their creator, helper threads
+	// started by a realtime thread drop them with the default settings
+	inline void reset(const std::string& name){ apply(Module_Config::Thread(), name); };
+
+	// parse a cpu list like "0-1,3", returns false on syntax errors
+	bool parse_cpus(const std::string&, cpu_set_t&);
+
+	// lock free distribution of thread wakeup latencies in power of two microsecond buckets
+	class Wakeup_Stats {
+		public:
+			void add(const float seconds);
+			void reset();
+			// prints approximate percentiles, the upper bound of their bucket
+			void report(std::ostream&, const std::string& name) const;
+
+		private:
+			static const size_t BUCKETS = 24;
+			std::array<std::atomic<uint32_t>, BUCKETS> count{};
+			std::atomic<uint32_t> max_us{0};
+
+			uint32_t percentile(const float, const uint64_t total) const;
+	};
+}
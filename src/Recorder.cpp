@@ -0,0 +1,101 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Recorder.hpp"
+#include "Realtime.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <iostream>
+
+// blocks are dropped if the disk can't keep up with this much queued data
+static const size_t MAX_QUEUE = 16 << 20;
+
+template<typename T>
+static inline void append(std::vector<char>& v, const T* data, const size_t n){
+	const char* bytes = reinterpret_cast<const char*>(data);
+	v.insert(v.end(), bytes, bytes + n * sizeof(T));
+}
+
+Recorder::Recorder(const std::string& filename, const long long f_sample, const unsigned channels){
+	file.open(filename, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if(!file.is_open()) throw std::runtime_error("Unable to open recording file: " + filename + " !");
+
+	Recording::Header header;
+	std::memcpy(header.magic, Recording::MAGIC, sizeof(header.magic));
+	header.version = Recording::VERSION;
+	header.f_sample = f_sample;
+	header.channels = channels;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	thread = std::thread(&Recorder::run, this);
+}
+
+Recorder::~Recorder(){
+	{
+		std::lock_guard<std::mutex> lock(mut);
+		running = false;
+	}
+	cv.notify_one();
+	thread.join();
+
+	if(dropped > 0){
+		std::cerr << "Recording dropped " << dropped << " blocks, the disk is too slow!" << std::endl;
+	}
+}
+
+void Recorder::write(const int16_t buf[], const size_t n, const Buffers::clock::time_point t){
+	if(!started){
+		t_start = t;
+		started = true;
+	}
+
+	int64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(t - t_start).count();
+	uint32_t length = n;
+	{
+		std::lock_guard<std::mutex> lock(mut);
+		if(queue.size() + sizeof(time) + sizeof(length) + n * sizeof(int16_t) > MAX_QUEUE){
+			dropped++;
+			return;
+		}
+		append(queue, &time, 1);
+		append(queue, &length, 1);
+		append(queue, buf, n);
+	}
+	cv.notify_one();
+}
+
+// write the queued blocks until the recorder is destroyed
+void Recorder::run(){
+	Realtime::reset("recorder");
+	std::vector<char> blocks;
+	std::unique_lock<std::mutex> lock(mut);
+	while(true){
+		cv.wait(lock, [this]{ return !queue.empty() || !running; });
+		if(queue.empty()) break;
+
+		// the queue keeps the memory of the last written blocks
+		std::swap(blocks, queue);
+		lock.unlock();
+		file.write(blocks.data(), blocks.size());
+		blocks.clear();
+		lock.lock();
+	}
+	file.flush();
+}
@@ -0,0 +1,69 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Buffer.hpp"
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// input recording format, all values in native byte order:
+//   header: char magic[8] = "GLMVREC", uint32_t version, uint32_t f_sample, uint32_t channels
+//   blocks: int64_t capture time in ns since the first block, uint32_t n, int16_t samples[n] (interleaved)
+namespace Recording {
+	static const char MAGIC[8] = "GLMVREC";
+	static const uint32_t VERSION = 1;
+
+	struct Header {
+		char magic[8];
+		uint32_t version, f_sample, channels;
+	};
+	static_assert(sizeof(Header) == 20, "Recording::Header has padding!");
+}
+
+// writes the blocks delivered by a realtime input into a recording, see Buffers::tap
+// the blocks are queued and written by a background thread, the input thread never waits for the disk
+class Recorder {
+	public:
+		Recorder(const std::string& file, const long long f_sample, const unsigned channels);
+		~Recorder();
+		Recorder(const Recorder&) = delete;
+
+		// called with Buffers::mut locked
+		void write(const int16_t buf[], const size_t n, const Buffers::clock::time_point t);
+
+	private:
+		std::ofstream file;
+		bool started = false;
+		Buffers::clock::time_point t_start;
+
+		// serialized blocks waiting for the writer thread
+		std::mutex mut;
+		std::condition_variable cv;
+		std::vector<char> queue;
+		bool running = true;
+		unsigned long long dropped = 0;
+		std::thread thread;
+
+		void run();
+};
@@ -0,0 +1,135 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Replay.hpp"
+#include "Recorder.hpp"
+#include "Realtime.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+Replay::~Replay(){
+	stop_stream();
+}
+
+void Replay::start_stream(const Module_Config::Input& input_config){
+	stop_stream();
+
+	file.open(input_config.file, std::ifstream::in | std::ifstream::binary);
+	if(!file.is_open()) throw std::runtime_error("Unable to open recording: " + input_config.file + " !");
+
+	file.seekg(0, std::ifstream::end);
+	file_size = file.tellg();
+	file.seekg(0);
+
+	Recording::Header header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if(!file || std::memcmp(header.magic, Recording::MAGIC, sizeof(header.magic)) != 0 || header.version != Recording::VERSION){
+		throw std::runtime_error(input_config.file + " isn't a GLMViz recording!");
+	}
+
+	// the samples are ingested unchanged, the channel layout has to match
+	unsigned channels = input_config.stereo ? 2 : 1;
+	if(header.channels != channels){
+		throw std::runtime_error("The recording has " + std::to_string(header.channels) + " channels, but the input is configured for "
+			+ std::to_string(channels) + "!");
+	}
+	if(header.f_sample != input_config.f_sample){
+		std::cerr << "Recording sample rate " << header.f_sample << "Hz doesn't match f_sample " << input_config.f_sample << "Hz!" << std::endl;
+	}
+
+	realtime = input_config.realtime;
+	pending = read_block();
+	t_start = Buffers::clock::now();
+
+	if(realtime){
+		running = true;
+		Module_Config::Thread sched = input_config.thread;
+		thread = std::thread([this, sched]{
+			Realtime::apply(sched, "replay");
+			play();
+		});
+	}
+}
+
+void Replay::stop_stream(){
+	if(thread.joinable()){
+		{
+			std::lock_guard<std::mutex> lock(mut);
+			running = false;
+		}
+		stop.notify_all();
+		thread.join();
+	}
+
+	file.close();
+	file.clear();
+	pending = false;
+	frame = 0;
+}
+
+bool Replay::read_block(){
+	uint32_t n = 0;
+	file.read(reinterpret_cast<char*>(&t_block), sizeof(t_block));
+	file.read(reinterpret_cast<char*>(&n), sizeof(n));
+	if(!file) return false;
+
+	// a corrupt length must not allocate more than the rest of the file
+	if(n * sizeof(int16_t) > static_cast<unsigned long long>(file_size - file.tellg())){
+		std::cerr << "Recording is truncated or corrupt!" << std::endl;
+		return false;
+	}
+	block.resize(n);
+	file.read(reinterpret_cast<char*>(block.data()), n * sizeof(int16_t));
+	return static_cast<bool>(file);
+}
+
+void Replay::ingest(){
+	std::lock_guard<std::mutex> lock(buffers->mut);
+	buffers->ingest(block.data(), block.size(), t_start + std::chrono::nanoseconds(t_block));
+}
+
+bool Replay::read_frame(const int fps){
+	// feed all blocks captured until the end of this frame
+	frame++;
+	// like the frame scheduler, a frame rate below 1 renders 1 fps
+	int64_t t_frame = frame * 1000000000ll / std::max(fps, 1);
+	bool fed = false;
+	while(pending && t_block < t_frame){
+		ingest();
+		pending = read_block();
+		fed = true;
+	}
+	return pending || fed;
+}
+
+// feed the blocks with the recorded time between them
+void Replay::play(){
+	std::unique_lock<std::mutex> lock(mut);
+	while(pending){
+		if(stop.wait_until(lock, t_start + std::chrono::nanoseconds(t_block), [this]{ return !running; })){
+			return;
+		}
+		ingest();
+		pending = read_block();
+	}
+	std::cout << "end of recording" << std::endl;
+}
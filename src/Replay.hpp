@@ -0,0 +1,68 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Input.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// plays back a recording of a realtime input, see Recorder
+// the blocks are fed with their original timing or frame by frame as fast as possible
+class Replay : public Input{
+public:
+	explicit Replay(Buffers::Ptr& buffers) : buffers(buffers){};
+
+	~Replay() override;
+
+	void start_stream(const Module_Config::Input&) override;
+
+	void stop_stream() override;
+
+	bool is_offline() const override { return !realtime; };
+
+	bool read_frame(const int fps) override;
+
+private:
+	Buffers::Ptr buffers;
+	std::ifstream file;
+	std::streamoff file_size = 0;
+	bool realtime = true;
+	// time of the first block, the blocks are ingested with their recorded capture time
+	Buffers::clock::time_point t_start;
+
+	// next block of the recording
+	bool pending = false;
+	int64_t t_block = 0; // ns since the first block
+	std::vector<int16_t> block;
+	unsigned long long frame = 0;
+
+	// realtime playback thread
+	std::thread thread;
+	std::mutex mut;
+	std::condition_variable stop;
+	bool running = false;
+
+	bool read_block();
+	void ingest();
+	void play();
+};
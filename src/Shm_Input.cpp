@@ -0,0 +1,152 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Shm_Input.hpp"
+#include "Trace.hpp"
+#include "Realtime.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// the reader checks for stop requests at least this often
+static const timespec WAIT_TIMEOUT = {0, 100000000};
+
+Shm_Input::~Shm_Input(){
+	stop_stream();
+}
+
+void Shm_Input::start_stream(const Module_Config::Input& input_config){
+	stop_stream();
+
+	int fd = shm_open(input_config.file.c_str(), O_RDWR, 0);
+	if(fd < 0) throw std::runtime_error("Unable to open shared memory ring: " + input_config.file + " !");
+
+	struct stat st;
+	if(fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(Shm_Ring::Header)){
+		close(fd);
+		throw std::runtime_error("Shared memory ring " + input_config.file + " is too small!");
+	}
+
+	map_size = st.st_size;
+	void* map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED) throw std::runtime_error("Can't map shared memory ring: " + std::string(std::strerror(errno)));
+	ring = reinterpret_cast<Shm_Ring::Header*>(map);
+
+	// the samples are ingested unchanged, the format has to match the input configuration
+	// the header is read once, only the validated values are used
+	std::string error;
+	const bool initialized = ring->magic.load(std::memory_order_acquire) == Shm_Ring::MAGIC && ring->version == Shm_Ring::VERSION;
+	const uint32_t format = ring->format;
+	capacity = ring->capacity;
+	channels = ring->channels;
+	const unsigned expected_channels = input_config.stereo ? 2 : 1;
+	if(!initialized){
+		error = input_config.file + " isn't an initialized GLMViz ring!";
+	}else if(format != Shm_Ring::FORMAT_S16 || capacity == 0 || Shm_Ring::size(capacity, channels) > map_size){
+		error = "Invalid shared memory ring format!";
+	}else if(channels != expected_channels){
+		error = "The ring has " + std::to_string(channels) + " channels, but the input is configured for " + std::to_string(expected_channels) + "!";
+	}
+	if(!error.empty()){
+		stop_stream();
+		throw std::runtime_error(error);
+	}
+	if(ring->f_sample != input_config.f_sample){
+		std::cerr << "Ring sample rate " << ring->f_sample << "Hz doesn't match f_sample " << input_config.f_sample << "Hz!" << std::endl;
+	}
+
+	// start with the newest data
+	read_index = ring->write_index.load(std::memory_order_acquire);
+
+	running = true;
+	Module_Config::Thread sched = input_config.thread;
+	thread = std::thread([this, sched]{
+		TRACE_THREAD("shm");
+		Realtime::apply(sched, "shm");
+		run();
+	});
+}
+
+void Shm_Input::stop_stream(){
+	if(thread.joinable()){
+		running = false;
+		Shm_Ring::wake(ring);
+		thread.join();
+	}
+
+	if(ring){
+		munmap(ring, map_size);
+		ring = nullptr;
+	}
+}
+
+void Shm_Input::run(){
+	while(running){
+		uint32_t sequence = ring->sequence.load(std::memory_order_acquire);
+		if(ring->write_index.load(std::memory_order_acquire) != read_index){
+			read();
+			continue;
+		}
+
+		// announce the sleep and check again, the producer only wakes waiting readers
+		ring->waiting = 1;
+		if(ring->sequence.load(std::memory_order_acquire) == sequence){
+			Shm_Ring::wait(ring, sequence, &WAIT_TIMEOUT);
+		}
+		ring->waiting = 0;
+	}
+}
+
+// ingest the published frames directly from the shared memory
+void Shm_Input::read(){
+	TRACE_SCOPE("Shm_Input::read");
+	uint64_t write_index = ring->write_index.load(std::memory_order_acquire);
+	auto t_capture = Buffers::clock::now();
+
+	// the oldest frames have already been overwritten
+	if(write_index - read_index > capacity){
+		read_index = write_index - capacity;
+		buffers->overruns++;
+	}
+	const uint64_t first = read_index;
+
+	std::unique_lock<std::mutex> lock(buffers->mut, std::defer_lock);
+	{
+		TRACE_SCOPE("lock Buffers::mut");
+		lock.lock();
+	}
+	while(read_index < write_index){
+		// copy up to the end of the ring
+		uint64_t start = read_index % capacity;
+		uint64_t n = std::min(write_index - read_index, capacity - start);
+		buffers->ingest(Shm_Ring::samples(ring) + start * channels, n * channels, t_capture);
+		read_index += n;
+	}
+
+	// the producer may have overwritten the frames while they were read
+	if(ring->write_index.load(std::memory_order_acquire) - first > capacity){
+		buffers->overruns++;
+	}
+}
@@ -0,0 +1,54 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Input.hpp"
+#include "Shm_Ring.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+
+// reads samples from a shared memory ring written by another local process, see Shm_Ring
+class Shm_Input : public Input{
+public:
+	explicit Shm_Input(Buffers::Ptr& buffers) : buffers(buffers){};
+
+	~Shm_Input() override;
+
+	void start_stream(const Module_Config::Input&) override;
+
+	void stop_stream() override;
+
+private:
+	Buffers::Ptr buffers;
+
+	Shm_Ring::Header* ring = nullptr;
+	size_t map_size = 0;
+	uint64_t read_index = 0;
+	// ring format validated by start_stream, the producer could change the shared header later
+	uint64_t capacity = 0;
+	unsigned channels = 0;
+
+	std::atomic<bool> running{false};
+	std::thread thread;
+
+	void run();
+	void read();
+};
@@ -0,0 +1,76 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+	Shared memory audio ring, written by one producer process and read by GLMViz.
+
+	The producer creates the object with shm_open(name, O_CREAT | O_RDWR), sizes it to
+	Shm_Ring::size(capacity, channels) and initializes the header before setting magic.
+	The header is followed by capacity frames of interleaved signed 16 bit native endian samples.
+
+	To publish n frames the producer copies them to the frames starting at write_index % capacity,
+	advances write_index with release ordering, increments sequence and calls wake() if waiting is set.
+	The reader never blocks the producer, if it falls behind by more than capacity frames the
+	oldest frames are lost.
+*/
+namespace Shm_Ring {
+	static const uint32_t MAGIC = 0x564d4c47; // "GLMV"
+	static const uint32_t VERSION = 1;
+	static const uint32_t FORMAT_S16 = 1;
+
+	struct Header {
+		std::atomic<uint32_t> magic; // set last by the producer
+		uint32_t version;
+		uint32_t format; // FORMAT_S16
+		uint32_t f_sample;
+		uint32_t channels;
+		uint32_t capacity; // ring size in frames
+		std::atomic<uint64_t> write_index; // total number of published frames
+		std::atomic<uint32_t> sequence; // futex word, incremented after every publish
+		std::atomic<uint32_t> waiting; // set by the reader before it sleeps on sequence
+	};
+	static_assert(sizeof(std::atomic<uint64_t>) == 8 && sizeof(std::atomic<uint32_t>) == 4, "Unexpected atomic size!");
+
+	inline size_t size(const uint32_t capacity, const uint32_t channels){
+		return sizeof(Header) + static_cast<size_t>(capacity) * channels * sizeof(int16_t);
+	}
+
+	inline int16_t* samples(Header* header){
+		return reinterpret_cast<int16_t*>(header + 1);
+	}
+
+	// sleep while sequence equals value, returns early on timeout or wake()
+	inline void wait(Header* header, const uint32_t value, const timespec* timeout){
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header->sequence), FUTEX_WAIT, value, timeout, nullptr, 0);
+	}
+
+	// wake up all readers
+	inline void wake(Header* header){
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header->sequence), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+	}
+}
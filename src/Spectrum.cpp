@@ -18,6 +18,9 @@
  */
 
 #include "Spectrum.hpp"
+#include "Program_Cache.hpp"
+#include "Profiler.hpp"
+#include "Trace.hpp"
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
@@ -26,59 +29,99 @@
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+// insert the Spectrum_Params block behind the #version line, its array holds one batch of Uniforms::MAX_SPECTRA
+static std::string with_spectrum_params(const char* code){
+	const char* params =
+	#include "shader/spectrum_params.glsl"
+	;
+
+	std::string source(code);
+	size_t version_end = source.find('\n', source.find("#version")) + 1;
+	source.insert(version_end, "#define MAX_SPECTRA " + std::to_string(Uniforms::MAX_SPECTRA) + "\n" + params);
+	return source;
+}
 
-Spectrum::Spectrum(const Module_Config::Spectrum& config, const unsigned s_id): output_size(0), id(s_id){
+Spectrum::Spectrum(): total_size(0), draw_lines(false){
 	init_bar_shader();
 	init_line_shader();
 	init_bar_pre_shader();
 
-	configure(config);
-
 	init_bars();
 	init_bars_pre();
 	init_lines();
+
+	// every batch binds a whole uniform block of the parameter buffer
+	batch_stride = Uniforms::aligned_size(Uniforms::MAX_SPECTRA * sizeof(Uniforms::Spectrum));
+
+	GL::Profiler& profiler = GL::Profiler::get();
+	st_lines = profiler.stage("spectrum dB lines");
+	st_tf = profiler.stage("spectrum gravity TF");
+	st_bars = profiler.stage("spectrum bars");
 }
 
-void Spectrum::draw(const float dt){
-	/* render lines */
+void Spectrum::draw(){
+	TRACE_SCOPE("Spectrum::draw");
+	if(instances.empty()) return;
+
+	const GLsizeiptr params_size = Uniforms::MAX_SPECTRA * sizeof(Uniforms::Spectrum);
+
+	/* render lines of all instances */
+	GL::Profiler& profiler = GL::Profiler::get();
 	if(draw_lines){
+		profiler.begin(st_lines);
 		sh_lines.use();
 		v_lines.bind();
-		glDrawArrays(GL_LINES, 0, 18);
+		for(size_t i = 0; i < batches.size(); i++){
+			b_params.ubobind(Uniforms::MODULE, i * batch_stride, params_size);
+			glDrawArraysInstanced(GL_LINES, 0, 18, batches[i].count);
+		}
+		profiler.end();
 	}
 
 	/* gravity processing shader */
+	profiler.begin(st_tf);
 	sh_bars_pre.use();
 
-	GLint i_dt = sh_bars_pre.get_uniform("dt");
-	glUniform1f(i_dt, dt);
-
 	v_bars_pre[tf_index].bind();
-	// bind first feedback buffer as TF buffer
-	b_fb[tf_index].tfbind();
 
 	glActiveTexture(GL_TEXTURE0);
 	t_fft.bind(GL_TEXTURE_BUFFER);
 
-	// begin transform feedback
-	glBeginTransformFeedback(GL_POINTS);
 	glEnable(GL_RASTERIZER_DISCARD);
-
-	glDrawArrays(GL_POINTS, 0, output_size);
+	for(size_t i = 0; i < batches.size(); i++){
+		const Batch& b = batches[i];
+		if(b.size == 0) continue;
+		b_params.ubobind(Uniforms::MODULE, i * batch_stride, params_size);
+		// capture the bars of the batch into the same range of the feedback buffer
+		b_fb[tf_index].tfbind(b.base * 2 * sizeof(float), b.size * 2 * sizeof(float));
+
+		glBeginTransformFeedback(GL_POINTS);
+		glDrawArrays(GL_POINTS, b.base, b.size);
+		glEndTransformFeedback();
+	}
 
 	// disable TF
 	glDisable(GL_RASTERIZER_DISCARD);
-	glEndTransformFeedback();
 	GL::Texture::unbind(GL_TEXTURE_BUFFER);
 
 	//undbind feedback buffer
 	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+	profiler.end();
 
 
 	/* render bars */
-	sh_bars[bar_shader_id].use();
+	profiler.begin(st_bars);
+	sh_bars.use();
 	v_bars[tf_index].bind();
-	glDrawArrays(GL_POINTS, 0, output_size);
+	for(size_t i = 0; i < batches.size(); i++){
+		b_params.ubobind(Uniforms::MODULE, i * batch_stride, params_size);
+		glDrawArrays(GL_POINTS, batches[i].base, batches[i].size);
+	}
+	profiler.end();
 
 	// switch tf buffers
 	tf_index = !tf_index;
@@ -95,160 +138,202 @@ void Spectrum::resize_tf_buffers(const size_t size){
 	glBufferData(GL_ARRAY_BUFFER, size * 2 * sizeof(float), 0, GL_DYNAMIC_DRAW);
 }
 
-void Spectrum::resize_x_buffer(const size_t size){
-	//std::vector<float> x_data(size);
-	//float f_size = (float)size;
-
-	// generate x positions ranging from -1 to 1
-	//for(unsigned int i = 0; i < size; i++){
-	//	x_data[i] = (((float) i + 0.5) - (f_size * 0.5)) / (f_size * 0.5);
-	//}
+void Spectrum::resize_instance_buffer(){
+	// store the instance index of every bar within its batch
+	std::vector<GLint> bar_instances(total_size);
+	for(unsigned i = 0; i < instances.size(); i++){
+		auto begin = bar_instances.begin() + instances[i].base;
+		std::fill(begin, begin + instances[i].output_size, i % Uniforms::MAX_SPECTRA);
+	}
 
-	//b_x.bind();
-	//glBufferData(GL_ARRAY_BUFFER, x_data.size() * sizeof(float), &x_data[2], GL_STATIC_DRAW);
+	b_instance.bind();
+	glBufferData(GL_ARRAY_BUFFER, bar_instances.size() * sizeof(GLint), bar_instances.data(), GL_STATIC_DRAW);
+	GL::Buffer::unbind();
 }
 
-void Spectrum::update_fft(FFT& fft){
+void Spectrum::update_fft(const std::vector<FFT>& ffts, const std::vector<FFT>& decimated){
+	TRACE_SCOPE("Spectrum::update_fft");
+	if(instances.empty()) return;
+
+	// gather the fft output of all instances and upload it at once
+	for(const Instance& inst : instances){
+		const FFT& fft = inst.stream >= 0 && decimated.size() > static_cast<size_t>(inst.stream) ? decimated[inst.stream] :
+		                 ffts.size() > inst.channel ? ffts[inst.channel] : ffts[0];
+		const float* data = fft.output[inst.offset];
+		std::copy(data, data + inst.output_size * 2, fft_data.begin() + inst.base * 2);
+		t_capture = std::max(t_capture, fft.t_capture);
+	}
+
 	b_fft.bind(GL_TEXTURE_BUFFER);
-	glBufferSubData(GL_TEXTURE_BUFFER, 0, output_size * sizeof(fftwf_complex), fft.output[offset]);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, fft_data.size() * sizeof(float), fft_data.data());
 	GL::Buffer::unbind(GL_TEXTURE_BUFFER);
+
+	t_update = std::chrono::steady_clock::now();
 }
 
-void Spectrum::update_fft(std::vector<FFT>& ffts){
-	if(ffts.size() > channel){
-		update_fft(ffts[channel]);
-	}else{
-		update_fft(ffts[0]);
-	}
+bool Spectrum::settled() const{
+	return std::chrono::steady_clock::now() - t_update > std::chrono::duration<float>(settle_time);
 }
 
 void Spectrum::resize_fft_buffer(const size_t size){
+	fft_data.resize(size * 2);
+
 	b_fft.bind(GL_TEXTURE_BUFFER);
-	glBufferData(GL_TEXTURE_BUFFER, output_size * sizeof(fftwf_complex), 0, GL_DYNAMIC_DRAW);
+	glBufferData(GL_TEXTURE_BUFFER, size * sizeof(fftwf_complex), 0, GL_DYNAMIC_DRAW);
+	GL::Buffer::unbind(GL_TEXTURE_BUFFER);
 }
 
-void Spectrum::configure(const Module_Config::Spectrum& scfg){
-	//const Config::Spectrum& scfg = cfg.spectra[id];
-	bar_shader_id = scfg.rainbow;
-	GL::Program& sh = sh_bars[bar_shader_id];
-	sh();
-	// Post compute specific uniforms
-	GLint i_width = sh.get_uniform("width");
-	glUniform1f(i_width, scfg.bar_width/(float)scfg.output_size);
-
-	// set bar color gradients
-	GLint i_top_color = sh.get_uniform("top_color");
-	glUniform4fv(i_top_color, 1, scfg.top_color.rgba);
-
-	GLint i_bot_color = sh.get_uniform("bot_color");
-	glUniform4fv(i_bot_color, 1, scfg.bot_color.rgba);
-
-	GLint i_gradient = sh.get_uniform("gradient");
-	glUniform1f(i_gradient, scfg.gradient);
-
-	GLint i_length = sh.get_uniform("length_1");
-	glUniform1f(i_length, 1./scfg.output_size);
-
-
-	sh_bars_pre.use();
-	// set precompute shader uniforms
-	GLint i_fft_scale = sh_bars_pre.get_uniform("fft_scale");
-	glUniform1f(i_fft_scale, scfg.scale);
-
-	GLint i_slope = sh_bars_pre.get_uniform("slope");
-	glUniform1f(i_slope, scfg.slope * 0.5);
-
-	GLint i_offset = sh_bars_pre.get_uniform("offset");
-	glUniform1f(i_offset, scfg.offset * 0.5);
-
-	GLint i_gravity = sh_bars_pre.get_uniform("gravity");
-	glUniform1f(i_gravity, scfg.gravity);
-
-	// set texture location
-	glUniform1i(sh_bars_pre.get_uniform("fft_tbo"), 0);
-
-	float o_size = float(scfg.output_size);
-	float b = std::log(o_size / scfg.log_start) / o_size;
-	float log_params[] = {
-		o_size / std::exp(b * o_size),
-		b,
-		scfg.log_enabled
-	};
-
-
-	GLint i_log_params = sh_bars_pre.get_uniform("log_params");
-	glUniform3fv(i_log_params, 1,log_params);
-
-	sh_lines.use();
-	// set dB line specific arguments
-	i_offset = sh_lines.get_uniform("offset");
-	glUniform1f(i_offset, scfg.offset);
+void Spectrum::configure(const std::vector<Module_Config::Spectrum>& scfgs){
+	size_t count = scfgs.size();
+	bool layout_changed = instances.size() != count;
+	instances.resize(count);
+	params.resize(count);
+
+	// range of parameter blocks that have to be uploaded
+	size_t first = count, last = 0;
+	size_t base = 0;
+	draw_lines = false;
+	settle_time = 0;
+	for(unsigned i = 0; i < count; i++){
+		const Module_Config::Spectrum& scfg = scfgs[i];
+		Instance& inst = instances[i];
+		Uniforms::Spectrum& p = params[i];
+
+		// instances behind a resized one are moved in the fft buffer
+		bool changed = i >= configs.size() || !(configs[i] == scfg) || inst.base != base;
+		layout_changed |= inst.output_size != static_cast<size_t>(scfg.output_size);
+		inst.output_size = scfg.output_size;
+		inst.offset = scfg.data_offset;
+		inst.base = base;
+		inst.channel = scfg.channel;
+		inst.stream = scfg.stream;
+		base += inst.output_size;
+
+		draw_lines |= scfg.dB_lines;
+		// falling time over the whole bar range (1.2)
+		if(scfg.gravity > 0){
+			settle_time = std::max(settle_time, std::sqrt(2.4f / scfg.gravity));
+		}
+
+		if(!changed) continue;
+		first = std::min<size_t>(first, i);
+		last = i + 1;
+
+		// Post compute specific uniforms
+		p.width = scfg.bar_width/(float)scfg.output_size;
+		p.length_1 = 1./scfg.output_size;
+
+		// set bar color gradients
+		std::copy(scfg.top_color.rgba, scfg.top_color.rgba + 4, p.top_color);
+		std::copy(scfg.bot_color.rgba, scfg.bot_color.rgba + 4, p.bot_color);
+		p.gradient = scfg.gradient;
+		p.rainbow = scfg.rainbow;
+
+		// set precompute shader uniforms
+		p.fft_scale = scfg.scale;
+		p.slope = scfg.slope;
+		p.offset = scfg.offset;
+		p.gravity = scfg.gravity;
+
+		float o_size = float(scfg.output_size);
+		float b = std::log(o_size / scfg.log_start) / o_size;
+		p.log_params[0] = o_size / std::exp(b * o_size);
+		p.log_params[1] = b;
+		p.log_params[2] = scfg.log_enabled;
+		p.log_params[3] = 0;
+
+		// set dB line color
+		std::copy(scfg.line_color.rgba, scfg.line_color.rgba + 4, p.line_color);
+		p.dB_lines = scfg.dB_lines;
+
+		p.base = inst.base;
+		p.size = inst.output_size;
+
+		set_transformation(p, scfg.pos);
+	}
 
-	i_slope = sh_lines.get_uniform("slope");
-	glUniform1f(i_slope, scfg.slope);
+	configs = scfgs;
+
+	batches.resize((count + Uniforms::MAX_SPECTRA - 1) / Uniforms::MAX_SPECTRA);
+	for(size_t i = 0; i < batches.size(); i++){
+		Batch& b = batches[i];
+		b.first = i * Uniforms::MAX_SPECTRA;
+		b.count = std::min<size_t>(Uniforms::MAX_SPECTRA, count - b.first);
+		b.base = instances[b.first].base;
+		b.size = 0;
+		for(size_t j = b.first; j < b.first + b.count; j++){
+			b.size += instances[j].output_size;
+		}
+	}
 
-	GLint i_line_color = sh_lines.get_uniform("line_color");
-	glUniform4fv(i_line_color, 1, scfg.line_color.rgba);
+	// grow the parameter buffer, all blocks have to be uploaded again
+	if(batches.size() > param_batches){
+		param_batches = batches.size();
+		b_params.bind(GL_UNIFORM_BUFFER);
+		glBufferData(GL_UNIFORM_BUFFER, param_batches * batch_stride, nullptr, GL_DYNAMIC_DRAW);
+		GL::Buffer::unbind(GL_UNIFORM_BUFFER);
+		first = 0;
+		last = count;
+	}
+	upload_params(first, last);
 
+	if(layout_changed){
+		resize(base);
+	}
+	t_update = std::chrono::steady_clock::now();
+}
 
-	resize(scfg.output_size);
-	offset = scfg.data_offset;
-	set_transformation(scfg.pos);
-	draw_lines = scfg.dB_lines;
-	// limit number of channels
-	channel = scfg.channel;
+// upload the parameters of the instances [first, last) into the ranges of their batches
+void Spectrum::upload_params(const size_t first, const size_t last){
+	if(first >= last) return;
+
+	b_params.bind(GL_UNIFORM_BUFFER);
+	for(size_t i = first; i < last;){
+		size_t batch = i / Uniforms::MAX_SPECTRA;
+		size_t end = std::min<size_t>(last, (batch + 1) * Uniforms::MAX_SPECTRA);
+		GLintptr offset = batch * batch_stride + (i % Uniforms::MAX_SPECTRA) * sizeof(Uniforms::Spectrum);
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, (end - i) * sizeof(Uniforms::Spectrum), params.data() + i);
+		i = end;
+	}
+	GL::Buffer::unbind(GL_UNIFORM_BUFFER);
 }
 
 void Spectrum::resize(const size_t size){
-	if(size != output_size){
-		output_size = size;
-		resize_tf_buffers(size);
-		resize_x_buffer(size);
-		resize_fft_buffer(size);
-	}
+	total_size = size;
+	resize_tf_buffers(size);
+	resize_instance_buffer();
+	resize_fft_buffer(size);
 }
 
-void Spectrum::set_transformation(const Module_Config::Transformation& t){
+void Spectrum::set_transformation(Uniforms::Spectrum& p, const Module_Config::Transformation& t){
 	// apply simple ortho transformation
 	glm::mat4 transformation = glm::ortho(t.Xmin, t.Xmax, t.Ymin, t.Ymax);
-
-	sh_bars[bar_shader_id].use();
-	GLint i_trans = sh_bars[bar_shader_id].get_uniform("trans");
-	glUniformMatrix4fv(i_trans, 1, GL_FALSE, glm::value_ptr(transformation));
-
-	sh_lines.use();
-	i_trans = sh_lines.get_uniform("trans");
-	glUniformMatrix4fv(i_trans, 1, GL_FALSE, glm::value_ptr(transformation));
+	const float* trans = glm::value_ptr(transformation);
+	std::copy(trans, trans + 16, p.trans);
 }
 
 void Spectrum::init_bar_shader(){
-	const char* vertex_shader =
+	const std::string vertex_shader = with_spectrum_params(
 	#include "shader/bar.vert"
-	;
-	GL::Shader vs(vertex_shader, GL_VERTEX_SHADER);
+	);
 
 	// fragment shader
-	const char* rainbow_shader =
-	#include "shader/rainbow.frag"
-	;
-	GL::Shader fs_rb(rainbow_shader, GL_FRAGMENT_SHADER);
-
 	const char* fragment_shader =
-	#include "shader/simple.frag"
+	#include "shader/bar.frag"
 	;
-	GL::Shader fs(fragment_shader, GL_FRAGMENT_SHADER);
 
 	// geometry shader
 	// draw bars
-	const char* geometry_shader =
+	const std::string geometry_shader = with_spectrum_params(
 	#include "shader/bar.geom"
-	;
-	GL::Shader gs(geometry_shader, GL_GEOMETRY_SHADER);
+	);
 
 	// link shaders
 	try{
-		sh_bars[0].link(fs, vs, gs);
-		sh_bars[1].link(fs_rb, vs, gs);
+		GL::Program_Cache::get().link(sh_bars, {{fragment_shader, GL_FRAGMENT_SHADER}, {vertex_shader.c_str(), GL_VERTEX_SHADER}, {geometry_shader.c_str(), GL_GEOMETRY_SHADER}});
+
+		sh_bars.bind_uniform_block("Spectrum_Params", Uniforms::MODULE);
+		sh_bars.bind_uniform_block("Frame", Uniforms::FRAME);
 	}
 	catch(std::invalid_argument& e){
 		std::cerr << "Can't link bar shaders!" << std::endl << e.what() << std::endl;
@@ -259,32 +344,37 @@ void Spectrum::init_bars(){
 	for(unsigned i = 0; i<2; i++){
 		v_bars[i].bind();
 
-		//b_x.bind();
-		// set x position data in bar VAO
-		//GLint arg_x_data = sh_bars[0].get_attrib("x");
-		//glVertexAttribPointer(arg_x_data, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
-		//glEnableVertexAttribArray(arg_x_data);
-
 		// enable the preprocessed y attribute
 		b_fb[i].bind();
-		GLint arg_y = sh_bars[0].get_attrib("y");
+		GLint arg_y = sh_bars.get_attrib("y");
 		glVertexAttribPointer(arg_y, 1, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (const GLvoid*)(sizeof(float)));
 		glEnableVertexAttribArray(arg_y);
 
+		// instance index of each bar
+		b_instance.bind();
+		GLint arg_instance = sh_bars.get_attrib("instance");
+		glVertexAttribIPointer(arg_instance, 1, GL_INT, 0, nullptr);
+		glEnableVertexAttribArray(arg_instance);
+
 		GL::Buffer::unbind();
 		GL::VAO::unbind();
 	}
 }
 
 void Spectrum::init_bar_pre_shader(){
-	const char* vertex_shader =
+	const std::string vertex_shader = with_spectrum_params(
 	#include "shader/bar_pre.vert"
-	;
-	GL::Shader vs(vertex_shader, GL_VERTEX_SHADER);
+	);
 
 	try{
-		const char* varyings[2] = {"v_time", "v_y"};
-		sh_bars_pre.link_TF(2, varyings, vs);
+		GL::Program_Cache::get().link(sh_bars_pre, {{vertex_shader.c_str(), GL_VERTEX_SHADER}}, {"v_time", "v_y"});
+
+		sh_bars_pre.bind_uniform_block("Spectrum_Params", Uniforms::MODULE);
+		sh_bars_pre.bind_uniform_block("Frame", Uniforms::FRAME);
+
+		// set texture location
+		sh_bars_pre.use();
+		glUniform1i(sh_bars_pre.get_uniform("tbo_fft"), 0);
 	}
 	catch(std::invalid_argument& e){
 		std::cerr << "Can't link bar_pre shader!" << std::endl << e.what() << std::endl;
@@ -296,12 +386,6 @@ void Spectrum::init_bars_pre(){
 		/* Pre compute shader */
 		v_bars_pre[i].bind();
 
-		//b_fft.bind();
-		// set fft_data buffer as vec2 input for the shader
-		//GLint arg_fft_output = sh_bars_pre.get_attrib("a");
-		//glVertexAttribPointer(arg_fft_output, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-		//glEnableVertexAttribArray(arg_fft_output);
-
 		// enable precompute shader attributes
 		b_fb[!i].bind();
 
@@ -313,10 +397,19 @@ void Spectrum::init_bars_pre(){
 		glVertexAttribPointer(arg_y_old, 1, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (const GLvoid*)sizeof(float));
 		glEnableVertexAttribArray(arg_y_old);
 
+		// instance index of each bar
+		b_instance.bind();
+		GLint arg_instance = sh_bars_pre.get_attrib("instance");
+		glVertexAttribIPointer(arg_instance, 1, GL_INT, 0, nullptr);
+		glEnableVertexAttribArray(arg_instance);
+
 		GL::Buffer::unbind();
 		GL::VAO::unbind();
 	}
 
+	// create the fft buffer before attaching it to the texture
+	resize_fft_buffer(0);
+
 	t_fft.bind(GL_TEXTURE_BUFFER);
 	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, b_fft.id);
 	GL::Texture::unbind(GL_TEXTURE_BUFFER);
@@ -327,15 +420,15 @@ void Spectrum::init_line_shader(){
 	const char* fragment_shader =
 	#include "shader/simple.frag"
 	;
-	GL::Shader fs(fragment_shader, GL_FRAGMENT_SHADER);
 
-	const char* vs_lines_code =
+	const std::string vs_lines_code = with_spectrum_params(
 	#include "shader/lines.vert"
-	;
-	GL::Shader vs_lines(vs_lines_code, GL_VERTEX_SHADER);
+	);
 
 	try{
-		sh_lines.link(fs, vs_lines);
+		GL::Program_Cache::get().link(sh_lines, {{fragment_shader, GL_FRAGMENT_SHADER}, {vs_lines_code.c_str(), GL_VERTEX_SHADER}});
+
+		sh_lines.bind_uniform_block("Spectrum_Params", Uniforms::MODULE);
 	}
 	catch(std::invalid_argument& e){
 		std::cerr << "Can't link dB line shader!" << std::endl << e.what() << std::endl;
@@ -22,38 +22,65 @@
 #include "FFT.hpp"
 #include "Module_Config.hpp"
 #include "GL_utils.hpp"
+#include "Uniforms.hpp"
 #include <memory>
 #include <array>
+#include <chrono>
 
+// batched renderer for all spectrum instances, drawn in batches of Uniforms::MAX_SPECTRA
 class Spectrum {
 	public:
-		Spectrum(const Module_Config::Spectrum&, const unsigned);
+		Spectrum();
 		// disable copy construction
 		Spectrum(const Spectrum&) = delete;
 		Spectrum(Spectrum&&) = default;
 		Spectrum& operator=(Spectrum&&) = default;
 		~Spectrum(){};
 
-		void draw(const float);
-		void update_fft(FFT&);
-		void update_fft(std::vector<FFT>&);
-		void configure(const Module_Config::Spectrum&);
+		void draw();
+		// decimated ffts are used by the spectra with a stream, see Config::decimation
+		void update_fft(const std::vector<FFT>&, const std::vector<FFT>& decimated = std::vector<FFT>());
+		void configure(const std::vector<Module_Config::Spectrum>&);
+		// true if all bars have reached the last uploaded fft values
+		bool settled() const;
+		// capture time of the newest uploaded sample
+		std::chrono::steady_clock::time_point captured() const { return t_capture; };
 
 	private:
-		GL::Program sh_bars_pre, sh_lines;
-		std::array<GL::Program, 2> sh_bars;
+		struct Instance {
+			size_t output_size = 0, offset = 0, base = 0;
+			unsigned channel = 0;
+			int stream = -1;
+		};
+
+		// instances sharing one range of the parameter buffer
+		struct Batch {
+			size_t first = 0, count = 0; // instances
+			size_t base = 0, size = 0; // bars
+		};
+
+		GL::Program sh_bars_pre, sh_lines, sh_bars;
 
 		GL::VAO v_lines;
 		std::array<GL::VAO, 2> v_bars, v_bars_pre;
 
-		GL::Buffer b_fft, b_lines;
+		GL::Buffer b_fft, b_lines, b_params, b_instance;
 		GL::Texture t_fft;
 		std::array<GL::Buffer, 2> b_fb;
 		unsigned tf_index = 0;
-		size_t output_size, offset;
+		unsigned st_lines, st_tf, st_bars; // profiler stages
+		size_t total_size;
 		bool draw_lines;
-		unsigned id, bar_shader_id, channel;
+		float settle_time = 0; // maximum time the bars need to fall to the bottom
+		std::chrono::steady_clock::time_point t_update, t_capture;
 
+		std::vector<Instance> instances;
+		std::vector<Batch> batches;
+		GLsizeiptr batch_stride; // aligned size of the parameters of a batch
+		size_t param_batches = 0; // batches allocated in b_params
+		std::vector<Module_Config::Spectrum> configs; // last applied configuration of each instance
+		std::vector<Uniforms::Spectrum> params;
+		std::vector<float> fft_data; // interleaved complex fft output of all instances
 
 		void init_bar_shader();
 		void init_bars();
@@ -63,8 +90,9 @@ class Spectrum {
 		void init_lines();
 
 		void resize_tf_buffers(const size_t);
-		void resize_x_buffer(const size_t);
+		void resize_instance_buffer();
 		void resize_fft_buffer(const size_t);
+		void upload_params(const size_t first, const size_t last);
 		void resize(const size_t);
-		void set_transformation(const Module_Config::Transformation&);
+		void set_transformation(Uniforms::Spectrum&, const Module_Config::Transformation&);
 };
@@ -0,0 +1,134 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Trace.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+using namespace Trace;
+
+static const auto t_start = std::chrono::steady_clock::now();
+
+// all thread buffers, they outlive their threads to keep the events for the dump
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<Thread_Buffer>> registry;
+// buffers of exited threads, reused by the next new thread
+static std::vector<Thread_Buffer*> free_buffers;
+static unsigned next_tid = 1;
+
+int64_t Trace::now(){
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t_start).count();
+}
+
+// returns the buffer of the owning thread to the free list when the thread exits
+struct Local_Buffer {
+	Thread_Buffer* buffer = nullptr;
+
+	~Local_Buffer(){
+		if(buffer == nullptr) return;
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		free_buffers.push_back(buffer);
+	}
+};
+
+Thread_Buffer& Trace::local(){
+	thread_local Local_Buffer local;
+	if(local.buffer == nullptr){
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		if(free_buffers.empty()){
+			registry.emplace_back(new Thread_Buffer());
+			local.buffer = registry.back().get();
+		}else{
+			// drop the events of the exited thread
+			local.buffer = free_buffers.back();
+			free_buffers.pop_back();
+			local.buffer->name.clear();
+			local.buffer->started.store(0, std::memory_order_relaxed);
+			local.buffer->count.store(0, std::memory_order_relaxed);
+		}
+		local.buffer->tid = next_tid++;
+	}
+	return *local.buffer;
+}
+
+void Trace::set_thread_name(const char* name){
+	Thread_Buffer& buffer = local();
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	buffer.name = name;
+}
+
+void Trace::dump(const std::string& file){
+	std::ofstream os(file, std::ofstream::trunc);
+	if(!os.is_open()){
+		std::cerr << "Can't write trace file " << file << "!" << std::endl;
+		return;
+	}
+
+	// timestamps in µs
+	os << std::fixed << std::setprecision(3);
+
+	// plain copies of the events of one buffer
+	struct Copy {
+		const char* name;
+		int64_t begin, end;
+	};
+	std::vector<Copy> events;
+	events.reserve(Thread_Buffer::CAPACITY);
+
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	os << "{\"traceEvents\":[" << std::endl;
+	bool first = true;
+	for(const auto& buffer : registry){
+		if(!buffer->name.empty()){
+			os << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+			   << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+			first = false;
+		}
+
+		// only the last CAPACITY events are kept, copy them while the thread keeps writing
+		size_t count = buffer->count.load(std::memory_order_acquire);
+		size_t begin = count > Thread_Buffer::CAPACITY ? count - Thread_Buffer::CAPACITY : 0;
+		events.clear();
+		for(size_t i = begin; i < count; i++){
+			const Event& e = buffer->events[i % Thread_Buffer::CAPACITY];
+			events.push_back({e.name.load(std::memory_order_relaxed), e.begin.load(std::memory_order_relaxed), e.end.load(std::memory_order_relaxed)});
+		}
+
+		// skip the oldest events if their slots were overwritten during the copy
+		std::atomic_thread_fence(std::memory_order_acquire);
+		size_t started = buffer->started.load(std::memory_order_relaxed);
+		size_t valid = started > begin + Thread_Buffer::CAPACITY ? started - Thread_Buffer::CAPACITY - begin : 0;
+
+		for(size_t i = std::min(valid, events.size()); i < events.size(); i++){
+			const Copy& e = events[i];
+			os << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+			   << ",\"ts\":" << e.begin / 1000.0 << ",\"dur\":" << (e.end - e.begin) / 1000.0 << "}";
+			first = false;
+		}
+	}
+	os << std::endl << "]}" << std::endl;
+
+	std::cout << "Trace written to " << file << std::endl;
+}
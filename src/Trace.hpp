@@ -0,0 +1,96 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Chrome trace event recording, compiled out without WITH_TRACE
+#ifdef WITH_TRACE
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// record the duration of the enclosing scope, name has to be a string literal
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+// name the calling thread, only the first call per thread and call site has an effect
+#define TRACE_THREAD(name) do{ static thread_local bool trace_named = (Trace::set_thread_name(name), true); (void)trace_named; }while(0)
+
+namespace Trace {
+	struct Event {
+		std::atomic<const char*> name;
+		std::atomic<int64_t> begin, end; // ns since the start of the trace
+	};
+
+	// per thread event ring buffer, only written by its own thread
+	// buffers of exited threads keep their events until a new thread reuses them
+	class Thread_Buffer {
+		public:
+			static const size_t CAPACITY = 1 << 16;
+
+			Thread_Buffer(): events(new Event[CAPACITY]){};
+
+			// started is published before an event slot is overwritten, count after it is complete
+			// a reader discards slots that were overwritten while it copied them
+			inline void add(const char* name, const int64_t begin, const int64_t end){
+				size_t i = count.load(std::memory_order_relaxed);
+				started.store(i + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+
+				Event& e = events[i % CAPACITY];
+				e.name.store(name, std::memory_order_relaxed);
+				e.begin.store(begin, std::memory_order_relaxed);
+				e.end.store(end, std::memory_order_relaxed);
+				count.store(i + 1, std::memory_order_release);
+			};
+
+			// only changed when the buffer is claimed by a thread, guarded by the registry mutex
+			unsigned tid = 0;
+			std::string name;
+
+			std::atomic<size_t> started{0}, count{0};
+			std::unique_ptr<Event[]> events;
+	};
+
+	int64_t now();
+	Thread_Buffer& local();
+	void set_thread_name(const char*);
+
+	// write all recorded events as Chrome trace event JSON
+	void dump(const std::string& file);
+
+	class Scope {
+		public:
+			explicit Scope(const char* n): name(n), begin(now()){};
+			~Scope(){ local().add(name, begin, now()); };
+
+		private:
+			const char* name;
+			int64_t begin;
+	};
+}
+
+#else
+
+#define TRACE_SCOPE(name) do{}while(0)
+#define TRACE_THREAD(name) do{}while(0)
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "GL_utils.hpp"
+#include <cstdint>
+#include <algorithm>
+
+// std140 uniform block layouts, these have to match the block declarations in the shaders
+namespace Uniforms {
+	// uniform block binding points
+	enum Binding : GLuint {
+		FRAME = 0,
+		MODULE = 1
+	};
+
+	// number of spectra drawn in one batch, sizes the Spectrum_Params block of the shaders
+	static const unsigned MAX_SPECTRA = 64;
+
+	// per frame parameters, shared by all modules
+	struct Frame {
+		float dt;
+		int32_t analytic_aa;
+		float viewport[2];
+	};
+
+	struct Spectrum {
+		float trans[16];
+		float top_color[4];
+		float bot_color[4];
+		float line_color[4];
+		float log_params[4]; // {a, b, log_switch}
+		float width;
+		float gradient;
+		float length_1;
+		float fft_scale;
+		float slope;
+		float offset;
+		float gravity;
+		int32_t rainbow;
+		int32_t base; // index of the first bar
+		int32_t size; // number of bars
+		int32_t dB_lines;
+		int32_t pad;
+	};
+
+	struct Oscilloscope {
+		float trans[16];
+		float line_color[4];
+		float scale;
+		float width;
+		float sigma;
+		float sigma_coeff;
+		float length_1;
+		float pad[3];
+	};
+
+	static_assert(sizeof(Frame) == 16, "Frame block doesn't match the std140 layout!");
+	static_assert(sizeof(Spectrum) == 176, "Spectrum block doesn't match the std140 layout!");
+	static_assert(sizeof(Oscilloscope) == 112, "Oscilloscope block doesn't match the std140 layout!");
+
+	// upload a block into a uniform buffer
+	template<typename T>
+	inline void upload(const GL::Buffer& ubo, const T& block){
+		ubo.bind(GL_UNIFORM_BUFFER);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(T), &block, GL_DYNAMIC_DRAW);
+		GL::Buffer::unbind(GL_UNIFORM_BUFFER);
+	}
+
+	// size of a block rounded up to the offset alignment of uniform buffer ranges,
+	// blocks stored at multiples of it can be bound with GL::Buffer::ubobind(index, offset, size)
+	inline GLsizeiptr aligned_size(const GLsizeiptr size){
+		GLint alignment = 1;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		alignment = std::max(alignment, 1);
+		return (size + alignment - 1) / alignment * alignment;
+	}
+
+	// per frame uniform buffer, bound to the FRAME binding point
+	class Frame_Block {
+		public:
+			Frame_Block(){
+				update(0, 1, 1, false);
+			};
+
+			inline void update(const float dt, const int width, const int height, const bool analytic_aa){
+				data.dt = dt;
+				data.analytic_aa = analytic_aa;
+				data.viewport[0] = width;
+				data.viewport[1] = height;
+				upload(ubo, data);
+				ubo.ubobind(FRAME);
+			};
+
+		private:
+			GL::Buffer ubo;
+			Frame data = {};
+	};
+}
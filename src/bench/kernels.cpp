@@ -0,0 +1,255 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// micro benchmarks of the audio processing kernels
+// usage: glmviz_bench [--json] [--filter <substring>] [--repetitions <n>]
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Buffer.hpp"
+#include "FFT.hpp"
+#include "Decimator.hpp"
+
+using bench_clock = std::chrono::steady_clock;
+
+// minimum duration of a single repetition
+static const std::chrono::milliseconds MIN_TIME(20);
+// samples written per Buffer::write call
+static const size_t BLOCK = 1024;
+static const std::vector<size_t> SIZES = {256, 1024, 4096, 16384, 65536};
+
+// keep the compiler from removing benchmarked code
+template<typename T>
+inline void keep(const T& value){
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Result {
+	std::string name;
+	size_t size, samples; // samples processed per operation
+	unsigned long iterations;
+	std::vector<double> ns; // ns/op of every repetition
+
+	double median() const {
+		std::vector<double> sorted(ns);
+		std::sort(sorted.begin(), sorted.end());
+		return sorted[sorted.size() / 2];
+	}
+
+	double mean() const {
+		return std::accumulate(ns.begin(), ns.end(), 0.) / ns.size();
+	}
+
+	double stddev() const {
+		double m = mean(), sum = 0;
+		for(double x : ns) sum += (x - m) * (x - m);
+		return std::sqrt(sum / ns.size());
+	}
+
+	double samples_per_s() const {
+		return samples * 1e9 / median();
+	}
+};
+
+class Bench {
+	public:
+		Bench(const std::string& f, const unsigned reps): filter(f), repetitions(reps){};
+
+		// time op, samples is the number of samples processed by a single call
+		void run(const std::string& name, const size_t size, const size_t samples, const std::function<void()>& op){
+			if(name.find(filter) == std::string::npos) return;
+
+			// calibrate the iteration count to the minimum repetition time, this also warms up the caches
+			unsigned long iterations = 1;
+			while(time(op, iterations) < MIN_TIME && iterations < (1ul << 30)){
+				iterations *= 2;
+			}
+
+			Result r = {name, size, samples, iterations, {}};
+			for(unsigned i = 0; i < repetitions; i++){
+				r.ns.push_back(std::chrono::duration<double, std::nano>(time(op, iterations)).count() / iterations);
+			}
+			results.push_back(r);
+		};
+
+		void print(std::ostream& os) const {
+			os.setf(std::ios::fixed);
+			os.precision(1);
+			for(const Result& r : results){
+				os << r.name << " [" << r.size << "]: " << r.median() << " ns/op (min " << *std::min_element(r.ns.begin(), r.ns.end())
+				   << ", +/- " << r.stddev() / r.mean() * 100 << "%), " << r.samples_per_s() / 1e6 << " M samples/s" << std::endl;
+			}
+		};
+
+		void print_json(std::ostream& os) const {
+			os.precision(3);
+			os.setf(std::ios::fixed);
+			os << "{\"repetitions\":" << repetitions << ",\"benchmarks\":[" << std::endl;
+			for(size_t i = 0; i < results.size(); i++){
+				const Result& r = results[i];
+				os << "{\"name\":\"" << r.name << "\",\"size\":" << r.size << ",\"iterations\":" << r.iterations
+				   << ",\"ns_per_op\":{\"median\":" << r.median() << ",\"mean\":" << r.mean()
+				   << ",\"min\":" << *std::min_element(r.ns.begin(), r.ns.end())
+				   << ",\"max\":" << *std::max_element(r.ns.begin(), r.ns.end()) << ",\"stddev\":" << r.stddev()
+				   << "},\"samples_per_s\":" << r.samples_per_s() << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+			}
+			os << "]}" << std::endl;
+		};
+
+	private:
+		std::string filter;
+		unsigned repetitions;
+		std::vector<Result> results;
+
+		bench_clock::duration time(const std::function<void()>& op, const unsigned long iterations){
+			auto start = bench_clock::now();
+			for(unsigned long i = 0; i < iterations; i++){
+				op();
+			}
+			return bench_clock::now() - start;
+		};
+};
+
+// white noise, the buffers skip writes of digital silence
+static std::vector<int16_t> noise(const size_t n){
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<int> dist(-32768, 32767);
+	std::vector<int16_t> data(n);
+	for(auto& x : data) x = dist(gen);
+	return data;
+}
+
+static void bench_buffer(Bench& bench){
+	for(size_t size : SIZES){
+		Buffer<int16_t> buf(size);
+		size_t block = std::min(size, BLOCK);
+
+		// interleaved input with up to 8 channels
+		std::vector<int16_t> data = noise(block * 8);
+
+		bench.run("Buffer::write", size, block, [&]{
+			buf.write(data.data(), block);
+		});
+
+		bench.run("Buffer::write_offset mono", size, block, [&]{
+			buf.write_offset(data.data(), block, 1, 0);
+		});
+
+		bench.run("Buffer::write_offset stereo", size, block, [&]{
+			buf.write_offset(data.data(), block * 2, 2, 0);
+		});
+
+		bench.run("Buffer::write_offset 8ch", size, block, [&]{
+			buf.write_offset(data.data(), block * 8, 8, 0);
+		});
+
+		bench.run("Buffer::rms", size, size, [&]{
+			float rms = buf.rms();
+			keep(rms);
+		});
+	}
+}
+
+static void bench_fft(Bench& bench){
+	for(size_t size : SIZES){
+		Buffer<int16_t> buf(size);
+		buf.write(noise(size));
+		FFT fft(size);
+
+		bench.run("FFT::calculate", size, size, [&]{
+			// force a new calculation on every call
+			buf.new_data = true;
+			bool updated = fft.calculate(buf);
+			keep(updated);
+		});
+
+		bench.run("FFT::magnitudes", size, size / 2 + 1, [&]{
+			auto mags = fft.magnitudes(32768);
+			keep(mags);
+		});
+
+		bench.run("FFT::max_bin", size, size / 2 + 1, [&]{
+			size_t bin = fft.max_bin(0, size / 2 + 1);
+			keep(bin);
+		});
+	}
+}
+
+static void bench_decimator(Bench& bench){
+	std::vector<int16_t> data = noise(BLOCK);
+	for(unsigned factor : {2, 4, 8}){
+		Buffer<int16_t> source(SIZES.back());
+		Decimator decimator(factor, SIZES.back());
+
+		// includes the write of the block into the source buffer
+		bench.run("Decimator::update /" + std::to_string(factor), SIZES.back(), BLOCK, [&]{
+			source.write(data.data(), BLOCK);
+			bool updated = decimator.update(source);
+			keep(updated);
+		});
+	}
+}
+
+int main(int argc, char* argv[]){
+	bool json = false;
+	std::string filter;
+	unsigned repetitions = 10;
+
+	try{
+		for(int i = 1; i < argc; i++){
+			std::string arg = argv[i];
+			if(arg == "--json"){
+				json = true;
+			}else if(arg == "--filter" && i + 1 < argc){
+				filter = argv[++i];
+			}else if(arg == "--repetitions" && i + 1 < argc){
+				repetitions = std::max(std::stoi(argv[++i]), 1);
+			}else{
+				throw std::invalid_argument("Unknown argument: " + arg);
+			}
+		}
+	}catch(std::logic_error& e){
+		std::cerr << e.what() << std::endl;
+		std::cerr << "usage: " << argv[0] << " [--json] [--filter <substring>] [--repetitions <n>]" << std::endl;
+		return 1;
+	}
+
+	Bench bench(filter, repetitions);
+	bench_buffer(bench);
+	bench_fft(bench);
+	bench_decimator(bench);
+
+	if(json){
+		bench.print_json(std::cout);
+	}else{
+		bench.print(std::cout);
+	}
+
+	return 0;
+}
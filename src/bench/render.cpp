@@ -0,0 +1,303 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// headless render benchmark of the spectrum and oscilloscope renderers
+// usage: glmviz_render_bench [--json] [--full] [--frames <n>] [--size <w>x<h>]
+// runs on any EGL implementation with surfaceless contexts, e.g. Mesa llvmpipe:
+//   LIBGL_ALWAYS_SOFTWARE=1 glmviz_render_bench
+// software renderers rasterize on glFinish, their timer queries don't cover all the work,
+// the frame time includes the glFinish and is comparable across renderers
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "EGLwindow.hpp"
+#include "GL_utils.hpp"
+#include "Multisampler.hpp"
+#include "Uniforms.hpp"
+#include "Spectrum.hpp"
+#include "Oscilloscope.hpp"
+
+using bench_clock = std::chrono::steady_clock;
+using ms = std::chrono::duration<double, std::milli>;
+
+static const int WARMUP_FRAMES = 10;
+static const float F_SAMPLE = 44100;
+
+// a point of the configuration matrix
+struct Point {
+	int output_size = 100;
+	int spectra = 1;
+	float bar_width = 0.5;
+	int duration = 50; // oscilloscope buffer length in ms, 0 disables the oscilloscopes
+	int oscilloscopes = 1;
+	std::string aa = "none"; // none, msaa or analytic
+
+	std::string name() const {
+		std::ostringstream ss;
+		ss << "output_size=" << output_size << " spectra=" << spectra << " bar_width=" << bar_width
+		   << " duration=" << duration << " oscilloscopes=" << oscilloscopes << " aa=" << aa;
+		return ss.str();
+	}
+};
+
+struct Timing {
+	std::vector<double> cpu, gpu, total; // ms per frame
+
+	static double percentile(std::vector<double> v, const double p){
+		if(v.empty()) return 0;
+		size_t i = std::min(static_cast<size_t>(p * v.size()), v.size() - 1);
+		std::nth_element(v.begin(), v.begin() + i, v.end());
+		return v[i];
+	}
+};
+
+// synthetic spectrum with moving peaks
+static void fill_fft(FFT& fft, const size_t size, const int frame){
+	for(size_t i = 0; i < size / 2 + 1; i++){
+		float a = 0.5f + 0.5f * std::sin(i * 0.05f + frame * 0.2f);
+		fft.output[i][0] = 2e7f * a * a;
+		fft.output[i][1] = 0;
+	}
+}
+
+// synthetic sine sweep for the oscilloscope
+static std::vector<int16_t> sine_block(const size_t n, const int frame){
+	std::vector<int16_t> block(n);
+	for(size_t i = 0; i < n; i++){
+		block[i] = 16000 * std::sin((frame * n + i) * 0.01f * (1 + frame % 5));
+	}
+	return block;
+}
+
+static Timing run(const Point& p, const int frames, const int width, const int height, const GL::FBO& target){
+	const size_t fft_size = 4096;
+
+	// spectra are stacked vertically
+	std::vector<Module_Config::Spectrum> scfgs(p.spectra);
+	for(int i = 0; i < p.spectra; i++){
+		scfgs[i].output_size = p.output_size;
+		scfgs[i].bar_width = p.bar_width;
+		scfgs[i].pos.Ymin = -1 + 2.f * i / p.spectra;
+		scfgs[i].pos.Ymax = -1 + 2.f * (i + 1) / p.spectra;
+		scfgs[i].dB_lines = true;
+	}
+
+	Spectrum spectra;
+	spectra.configure(scfgs);
+
+	std::vector<FFT> ffts;
+	ffts.emplace_back(fft_size);
+
+	std::vector<Buffer<int16_t>> bufs;
+	bufs.emplace_back(std::max<size_t>(F_SAMPLE * p.duration / 1000, 1));
+	// oscilloscopes are stacked vertically as well and share the sample buffer
+	std::unique_ptr<Oscilloscope> osc;
+	if(p.duration > 0){
+		std::vector<Module_Config::Oscilloscope> ocfgs(p.oscilloscopes);
+		for(int i = 0; i < p.oscilloscopes; i++){
+			ocfgs[i].pos.Ymin = -1 + 2.f * i / p.oscilloscopes;
+			ocfgs[i].pos.Ymax = -1 + 2.f * (i + 1) / p.oscilloscopes;
+		}
+		osc.reset(new Oscilloscope());
+		osc->configure(ocfgs);
+	}
+	// new samples per frame at 60 fps
+	const size_t block = F_SAMPLE / 60;
+
+	std::unique_ptr<GL::Multisampler> msaa;
+	if(p.aa == "msaa"){
+		msaa.reset(new GL::Multisampler(4, width, height));
+	}
+	Uniforms::Frame_Block frame_block;
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	Timing t;
+	for(int frame = -WARMUP_FRAMES; frame < frames; frame++){
+		fill_fft(ffts[0], fft_size, frame);
+		bufs[0].write(sine_block(block, frame));
+
+		glFinish();
+		auto t_start = bench_clock::now();
+		glBeginQuery(GL_TIME_ELAPSED, query);
+
+		if(msaa){
+			msaa->bind();
+		}else{
+			target.bind();
+		}
+		glClear(GL_COLOR_BUFFER_BIT);
+		frame_block.update(1.f / 60, width, height, p.aa == "analytic");
+
+		spectra.update_fft(ffts);
+		spectra.draw();
+		if(osc){
+			osc->update_buffer(bufs);
+			osc->draw();
+		}
+		if(msaa){
+			msaa->blit(width, height, target);
+		}
+
+		glEndQuery(GL_TIME_ELAPSED);
+		auto t_submit = bench_clock::now();
+		glFinish();
+		auto t_end = bench_clock::now();
+
+		GLuint64 gpu_ns;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpu_ns);
+
+		if(frame >= 0){
+			t.cpu.push_back(ms(t_submit - t_start).count());
+			t.gpu.push_back(gpu_ns / 1e6);
+			t.total.push_back(ms(t_end - t_start).count());
+		}
+	}
+	glDeleteQueries(1, &query);
+	GLDEBUG;
+
+	return t;
+}
+
+static std::vector<Point> matrix(const bool full){
+	const std::vector<int> output_sizes = {50, 200, 1000};
+	const std::vector<int> spectra = {1, 4, 16, 64, 128};
+	const std::vector<float> bar_widths = {0.2, 0.5, 1.0};
+	const std::vector<int> durations = {0, 50, 200};
+	const std::vector<int> oscilloscopes = {1, 16, 64};
+	const std::vector<std::string> aas = {"none", "msaa", "analytic"};
+
+	std::vector<Point> points;
+	if(full){
+		for(int o : output_sizes) for(int s : spectra) for(float b : bar_widths) for(int d : durations) for(int n : oscilloscopes) for(auto& a : aas){
+			Point p;
+			p.output_size = o; p.spectra = s; p.bar_width = b; p.duration = d; p.oscilloscopes = n; p.aa = a;
+			points.push_back(p);
+		}
+		return points;
+	}
+
+	// vary one parameter at a time
+	const Point base;
+	points.push_back(base);
+	for(int o : output_sizes){ Point p = base; p.output_size = o; points.push_back(p); }
+	for(int s : spectra){ Point p = base; p.spectra = s; points.push_back(p); }
+	for(float b : bar_widths){ Point p = base; p.bar_width = b; points.push_back(p); }
+	for(int d : durations){ Point p = base; p.duration = d; points.push_back(p); }
+	for(int n : oscilloscopes){ Point p = base; p.oscilloscopes = n; points.push_back(p); }
+	for(auto& a : aas){ Point p = base; p.aa = a; points.push_back(p); }
+
+	// remove repetitions of the base point
+	std::vector<Point> unique;
+	for(const Point& p : points){
+		auto same = [&](const Point& q){ return q.name() == p.name(); };
+		if(std::none_of(unique.begin(), unique.end(), same)) unique.push_back(p);
+	}
+	return unique;
+}
+
+int main(int argc, char* argv[]){
+	bool json = false, full = false;
+	int frames = 200, width = 1280, height = 720;
+
+	try{
+		for(int i = 1; i < argc; i++){
+			std::string arg = argv[i];
+			if(arg == "--json"){
+				json = true;
+			}else if(arg == "--full"){
+				full = true;
+			}else if(arg == "--frames" && i + 1 < argc){
+				frames = std::max(std::stoi(argv[++i]), 1);
+			}else if(arg == "--size" && i + 1 < argc){
+				std::string size = argv[++i];
+				size_t x = size.find('x');
+				if(x == std::string::npos) throw std::invalid_argument("Invalid size: " + size);
+				width = std::stoi(size.substr(0, x));
+				height = std::stoi(size.substr(x + 1));
+			}else{
+				throw std::invalid_argument("Unknown argument: " + arg);
+			}
+		}
+	}catch(std::logic_error& e){
+		std::cerr << e.what() << std::endl;
+		std::cerr << "usage: " << argv[0] << " [--json] [--full] [--frames <n>] [--size <w>x<h>]" << std::endl;
+		return 1;
+	}
+
+	try{
+		EGLwindow window;
+		std::cerr << "Renderer: " << glGetString(GL_RENDERER) << ", " << width << "x" << height << ", "
+			<< frames << " frames" << std::endl;
+
+		GL::Texture tex;
+		tex.bind(GL_TEXTURE_2D);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		GL::Texture::unbind(GL_TEXTURE_2D);
+		GL::FBO target;
+		target.bind();
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex.id, 0);
+
+		glViewport(0, 0, width, height);
+		glClearColor(0, 0, 0, 1);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glEnable(GL_BLEND);
+
+		std::cout.setf(std::ios::fixed);
+		std::cout.precision(3);
+		if(json) std::cout << "{\"renderer\":\"" << glGetString(GL_RENDERER) << "\",\"width\":" << width
+			<< ",\"height\":" << height << ",\"frames\":" << frames << ",\"results\":[" << std::endl;
+
+		std::vector<Point> points = matrix(full);
+		for(size_t i = 0; i < points.size(); i++){
+			const Point& p = points[i];
+			Timing t = run(p, frames, width, height, target);
+
+			if(json){
+				std::cout << "{\"output_size\":" << p.output_size << ",\"spectra\":" << p.spectra
+					<< ",\"bar_width\":" << p.bar_width << ",\"duration\":" << p.duration << ",\"oscilloscopes\":" << p.oscilloscopes << ",\"aa\":\"" << p.aa << "\"";
+				for(auto m : {std::make_pair("cpu_ms", &t.cpu), std::make_pair("gpu_ms", &t.gpu), std::make_pair("frame_ms", &t.total)}){
+					std::cout << ",\"" << m.first << "\":{\"p50\":" << Timing::percentile(*m.second, 0.5)
+						<< ",\"p95\":" << Timing::percentile(*m.second, 0.95) << "}";
+				}
+				std::cout << "}" << (i + 1 < points.size() ? "," : "") << std::endl;
+			}else{
+				std::cout << p.name() << ": cpu " << Timing::percentile(t.cpu, 0.5) << " ms, gpu "
+					<< Timing::percentile(t.gpu, 0.5) << " ms, frame " << Timing::percentile(t.total, 0.5)
+					<< " ms (p95 " << Timing::percentile(t.total, 0.95) << " ms)" << std::endl;
+			}
+		}
+		if(json) std::cout << "]}" << std::endl;
+	}catch(std::runtime_error& e){
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
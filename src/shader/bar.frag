@@ -1,8 +1,9 @@
 R"(
 #version 150
 
-// sinebow fragment shader
 in vec4 color;
+flat in int rainbow;
+noperspective in vec4 edge;
 
 out vec4 f_color;
 
@@ -16,12 +17,26 @@ const vec3 offset = vec3(0.5, 0.5, 0.5);
 
 // gamma correction
 const vec3 gamma = vec3(2.2);
+
+// pixel coverage of the bar, box filtered
+float coverage(){
+	vec4 d = min(edge, 0.5);
+	return clamp(d.x + d.y, 0.0, 1.0) * clamp(d.z + d.w, 0.0, 1.0);
+}
+
 void main () {
+	if(rainbow == 0){
+		f_color = color;
+		f_color.a *= coverage();
+		return;
+	}
+
+	// sinebow color
 	vec3 ccos = cos(pi2 * color.rgb + phase);
 	vec3 rb_color = scale * ccos + offset;
 
 	// apply gamma correction
 	f_color.rgb = pow(rb_color, gamma);
-	f_color.a = color.a;
+	f_color.a = color.a * coverage();
 }
 )"
@@ -3,20 +3,22 @@ R"(
 // old values from TF
 in float time_old;
 in float y_old;
+in int instance;
 
 // new TF values + current y value
 out float v_time;
 out float v_y;
 
-uniform float fft_scale;
-uniform float slope;
-uniform float offset;
-uniform float gravity;
+// the Spectrum_Params block of all batched spectra is prepended, see spectrum_params.glsl
+
+layout(std140) uniform Frame {
+	float dt;
+	int analytic_aa;
+	vec2 viewport; // framebuffer size in pixels
+};
 
 // fft texture buffer
 uniform samplerBuffer tbo_fft;
-uniform vec3 log_params; //{ a, b, log_switch}
-uniform float dt;
 
 const float lg = 1. / log(10.);
 
@@ -25,22 +27,31 @@ float gt(float x, float y){
 	return max(sign(x - y), 0.0);
 }
 
-float acc(float t){
+float acc(float gravity, float t){
 	return -gravity * t;
 }
 
+// fetch the fft magnitude of a bar, bars outside of the spectrum are 0
+float fetch(Spectrum s, int i){
+	if(i < 0 || i >= s.size) return 0.0;
+	return length(texelFetch(tbo_fft, s.base + i).xy) * s.fft_scale;
+}
+
 void main(){
+	Spectrum s = spectra[instance];
+	int id = gl_VertexID - s.base;
+
 	// fetch fft output
 	float a;
-	if(log_params.z > 0.0){
+	if(s.log_params.z > 0.0){
 		// log fetch
-		float i = log_params.x * exp(log_params.y * gl_VertexID);
+		float i = s.log_params.x * exp(s.log_params.y * id);
 		int i_f = int(floor(i));
 		// fetch both indices and tangents
-		float a_0 = length(texelFetch(tbo_fft, i_f - 1).xy) * fft_scale;
-		float a_1 = length(texelFetch(tbo_fft, i_f).xy) * fft_scale;
-		float a_2 = length(texelFetch(tbo_fft, i_f + 1).xy) * fft_scale;
-		float a_3 = length(texelFetch(tbo_fft, i_f + 2).xy) * fft_scale;
+		float a_0 = fetch(s, i_f - 1);
+		float a_1 = fetch(s, i_f);
+		float a_2 = fetch(s, i_f + 1);
+		float a_3 = fetch(s, i_f + 2);
 		float t0 = a_1 - a_0;
 		float t1 = a_3 - a_2;
 		// interpolate fft values
@@ -52,11 +63,11 @@ void main(){
 			(-2. * x3 +3. * x2) * a_2 + (x3 - x2) * t1;
 	}else{
 		// linear fetch
-		a = length(texelFetch(tbo_fft, gl_VertexID).xy) * fft_scale;
+		a = fetch(s, id);
 	}
 
 	// convert fft output into dB
-	float y = slope * log(a) * lg + offset;
+	float y = 0.5 * (s.slope * log(a) * lg + s.offset);
 
 	// clamp values
 	float y_o = clamp(y_old, -0.5, 0.7);
@@ -64,9 +75,9 @@ void main(){
 	float time = max(time_old, 0.0);
 
 	// RK4 integration
-	float k1 = acc(time);
-	float k2 = acc(time + dt * 0.5);
-	float k4 = acc(time + dt);
+	float k1 = acc(s.gravity, time);
+	float k2 = acc(s.gravity, time + dt * 0.5);
+	float k4 = acc(s.gravity, time + dt);
 	float dydt = 1./6. * (k1 + 4. * k2 + k4);
 
 	// calculate gravity
@@ -5,16 +5,20 @@ in vec2 pos;
 
 out vec4 color;
 
-uniform float slope;
-uniform float offset;
-uniform vec4 line_color;
-uniform mat4 trans;
+// the Spectrum_Params block of all batched spectra is prepended, see spectrum_params.glsl
 
 //const float div255 = 1.0/255.0;
 //const vec4 n_color = vec4(div255, div255, div255, 1.0);
 void main () {
-	color = line_color;
+	Spectrum s = spectra[gl_InstanceID];
+
+	color = s.line_color;
 	// limit line range from 1 to -1
-	gl_Position = trans * vec4 (pos.x, clamp(slope * pos.y + offset, -1.0, 1.0) , 0.0, 1.0);
+	gl_Position = s.trans * vec4 (pos.x, clamp(s.slope * pos.y + s.offset, -1.0, 1.0) , 0.0, 1.0);
+
+	// clip lines of instances with disabled dB lines
+	if(s.dB_lines == 0){
+		gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+	}
 }
 )"
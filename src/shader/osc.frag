@@ -5,10 +5,21 @@ in vec4 t;
 
 out vec4 f_color;
 
+layout(std140) uniform Frame {
+	float dt;
+	int analytic_aa;
+	vec2 viewport; // framebuffer size in pixels
+};
+
 void main () {
 	// calculate 2d gaussian function
 	float alpha = exp(-(t.x*t.x*t.z + t.y*t.y*t.w));
 
+	if(analytic_aa != 0){
+		// fade out the line border over one pixel
+		alpha *= clamp((1.0 - abs(t.x)) / fwidth(t.x), 0.0, 1.0);
+	}
+
 	f_color = vec4(color.rgb, alpha);
 }
 )"
@@ -2,8 +2,15 @@ R"(
 #version 150
 in float y;
 
-uniform float length_1; // 1/length
-uniform float scale;
+layout(std140) uniform Oscilloscope_Params {
+	mat4 trans;
+	vec4 line_color;
+	float scale;
+	float width;
+	float sigma;
+	float sigma_coeff;
+	float length_1; // 1/length
+};
 
 void main(){
 	// calculate x coordinate
@@ -0,0 +1,26 @@
+R"(
+struct Spectrum {
+	mat4 trans;
+	vec4 top_color;
+	vec4 bot_color;
+	vec4 line_color;
+	vec4 log_params; //{ a, b, log_switch}
+	float width;
+	// switch gradient, 0:full range per bar, 1:0dB has top_color
+	float gradient;
+	float length_1;
+	float fft_scale;
+	float slope;
+	float offset;
+	float gravity;
+	int rainbow;
+	int base; // index of the first bar
+	int size; // number of bars
+	int dB_lines;
+};
+
+// parameters of all batched spectra
+layout(std140) uniform Spectrum_Params {
+	Spectrum spectra[MAX_SPECTRA];
+};
+)"
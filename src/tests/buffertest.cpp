@@ -21,8 +21,11 @@
 #include <numeric>
 #include <algorithm>
 #include <stdexcept>
+#include <cstdlib>
+#include <cmath>
 
 #include "Buffer.hpp"
+#include "Decimator.hpp"
 
 template<typename T>
 inline void dump(Buffer<T>& buffer){
@@ -115,6 +118,77 @@ int main(){
 			if(neq(buf, result)) throw std::runtime_error("Interleaved append with offset pointer");
 		}
 
+		std::cout << "Silence detection" << std::endl;
+		{
+			uint64_t seq = buf.seq;
+			buf.write({0,0,0});
+			if(buf.seq == seq) throw std::runtime_error("Silence detection");
+			buf.write({0,0});
+			seq = buf.seq;
+			// the buffer is completely silent, further silence doesn't change it
+			buf.write({0,0});
+			std::vector<int16_t> result(nsize, 0);
+			if(buf.seq != seq || neq(buf, result)) throw std::runtime_error("Silence detection");
+			buf.write({1});
+			if(buf.seq == seq) throw std::runtime_error("Silence detection");
+		}
+
+		std::cout << "Capture time" << std::endl;
+		{
+			auto t = Buffer<int16_t>::clock::now() - std::chrono::milliseconds(10);
+			buf.write({1, 2}, t);
+			if(buf.t_capture != t) throw std::runtime_error("Capture time");
+			buf.write_offset({3, 4, 5, 6}, 2, 0);
+			if(buf.t_capture <= t) throw std::runtime_error("Capture time");
+		}
+
+		std::cout << "Sample accounting" << std::endl;
+		{
+			Buffer<int16_t> abuf(4);
+			abuf.write({1, 2, 3});
+			abuf.consume();
+			// one analysed sample is shifted out
+			abuf.write({4, 5});
+			// two pending samples are shifted out, two samples don't fit
+			abuf.write({6, 7, 8, 9, 10, 11});
+			if(abuf.stats.received != 11 || abuf.stats.truncated != 2 || abuf.stats.overwritten != 2)
+				throw std::runtime_error("Sample accounting");
+		}
+
+		std::cout << "Decimation" << std::endl;
+		{
+			// dc passes, the nyquist frequency is removed, written in blocks that don't align with the factor
+			Buffer<int16_t> dc(1024), nyquist(1024);
+			Decimator d_dc(4, 1024), d_nyquist(4, 1024);
+			for(int block = 0; block < 10; block++){
+				std::vector<int16_t> ones(301, 1000), alternating(301);
+				for(size_t i = 0; i < alternating.size(); i++) alternating[i] = (block * 301 + i) % 2 ? 1000 : -1000;
+				dc.write(ones);
+				nyquist.write(alternating);
+				d_dc.update(dc);
+				d_nyquist.update(nyquist);
+			}
+			if(d_dc.buffer.size != 256 || std::abs(d_dc.buffer.v_buffer.back() - 1000) > 1 || std::abs(d_nyquist.buffer.v_buffer.back()) > 1)
+				throw std::runtime_error("Decimation");
+
+			// frequencies that fold into the analysed range are attenuated by more than 78 dB
+			for(unsigned factor : {2u, 4u, 8u}){
+				for(float f = 0.6f / factor; f <= 0.5f; f += 0.01f / factor){
+					Buffer<int16_t> tone(1024);
+					Decimator d_tone(factor, 1024);
+					for(int block = 0; block < 20; block++){
+						std::vector<int16_t> samples(301);
+						for(size_t i = 0; i < samples.size(); i++) samples[i] = std::round(32000 * std::sin(2 * M_PI * f * (block * 301 + i)));
+						tone.write(samples);
+						d_tone.update(tone);
+					}
+					for(int16_t v : d_tone.buffer.v_buffer){
+						if(std::abs(v) > 3) throw std::runtime_error("Decimation stopband");
+					}
+				}
+			}
+		}
+
 	}
 	catch(std::runtime_error& e){
 		std::cerr << e.what() << " Failed!" << std::endl;
@@ -0,0 +1,125 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+
+#include "Module_Config.hpp"
+
+// the config reload only reconfigures the parts whose configs compare unequal
+template<typename T>
+inline bool changed(const T& a, const T& b){
+	return !(a == b);
+}
+
+int main(){
+	try{
+		std::cout << "Input" << std::endl;
+		{
+			Module_Config::Input a, b;
+			if(changed(a, b)) throw std::runtime_error("Input default");
+
+			// a new record file is applied without restarting the input
+			b.record = "/tmp/GLMViz.rec";
+			if(changed(a, b)) throw std::runtime_error("Input record");
+
+			// realtime only changes how recordings are replayed
+			b.realtime = false;
+			if(changed(a, b)) throw std::runtime_error("Input realtime");
+			a.source = b.source = Module_Config::Source::REPLAY;
+			if(!changed(a, b)) throw std::runtime_error("Input replay realtime");
+
+			b = a;
+			b.file = "/tmp/GLMViz.wav";
+			if(!changed(a, b)) throw std::runtime_error("Input file");
+			b = a;
+			b.device = "hw:1";
+			if(!changed(a, b)) throw std::runtime_error("Input device");
+			b = a;
+			b.latency = 2048;
+			if(!changed(a, b)) throw std::runtime_error("Input latency");
+			b = a;
+			b.port = 5005;
+			if(!changed(a, b)) throw std::runtime_error("Input port");
+			b = a;
+			b.stereo = true;
+			if(!changed(a, b)) throw std::runtime_error("Input stereo");
+			b = a;
+			b.thread.cpus = "1";
+			if(!changed(a, b)) throw std::runtime_error("Input thread");
+		}
+
+		std::cout << "FFT and decimation" << std::endl;
+		{
+			Module_Config::FFT a, b;
+			if(changed(a, b)) throw std::runtime_error("FFT default");
+			b.size = 1 << 13;
+			if(!changed(a, b)) throw std::runtime_error("FFT size");
+
+			std::vector<Module_Config::Decimation> da(2), db(2);
+			if(changed(da, db)) throw std::runtime_error("Decimation default");
+			db[1].factor = 4;
+			if(!changed(da, db)) throw std::runtime_error("Decimation factor");
+		}
+
+		std::cout << "Spectrum" << std::endl;
+		{
+			std::vector<Module_Config::Spectrum> a(3), b(3);
+			if(changed(a, b)) throw std::runtime_error("Spectrum default");
+
+			// every group of fields takes part in the comparison
+			b[2].output_size = 200;
+			if(!changed(a[2], b[2]) || changed(a[1], b[1]) || !changed(a, b)) throw std::runtime_error("Spectrum output size");
+			b = a;
+			b[0].top_color.rgba[3] = 0.5;
+			if(!changed(a, b)) throw std::runtime_error("Spectrum color");
+			b = a;
+			b[1].pos.Ymax = 0;
+			if(!changed(a, b)) throw std::runtime_error("Spectrum position");
+			b = a;
+			b[1].dB_lines = true;
+			if(!changed(a, b)) throw std::runtime_error("Spectrum dB lines");
+
+			// added and removed spectra
+			b = a;
+			b.emplace_back();
+			if(!changed(a, b)) throw std::runtime_error("Spectrum count");
+		}
+
+		std::cout << "Oscilloscope" << std::endl;
+		{
+			std::vector<Module_Config::Oscilloscope> a(2), b(2);
+			if(changed(a, b)) throw std::runtime_error("Oscilloscope default");
+			b[1].channel = 1;
+			if(!changed(a, b) || changed(a[0], b[0])) throw std::runtime_error("Oscilloscope channel");
+			b = a;
+			b[0].color.rgba[0] = 0;
+			if(!changed(a, b)) throw std::runtime_error("Oscilloscope color");
+			b = a;
+			b[0].pos.Xmin = 0;
+			if(!changed(a, b)) throw std::runtime_error("Oscilloscope position");
+		}
+	}
+	catch(std::runtime_error& e){
+		std::cerr << e.what() << " Failed!" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <cstdint>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Net_Input.hpp"
+
+// samples per packet, every sample of a packet carries its sequence number
+const size_t frames = 4;
+
+// loopback sender of single packets in a chosen order
+class Sender{
+	public:
+		Sender(const int port){
+			sock = socket(AF_INET, SOCK_DGRAM, 0);
+			if(sock < 0) throw std::runtime_error("Sender socket");
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = htons(port);
+		};
+		~Sender(){ close(sock); };
+
+		// simple framing: sequence number and timestamp
+		void udp(const uint32_t seq){
+			std::vector<uint8_t> p;
+			put32(p, seq);
+			put32(p, seq * frames);
+			payload(p, seq);
+		};
+
+		// RTP with L16 payload
+		void rtp(const uint16_t seq, const uint32_t ssrc){
+			std::vector<uint8_t> p = {0x80, 11};
+			p.push_back(seq >> 8);
+			p.push_back(seq);
+			put32(p, seq * frames);
+			put32(p, ssrc);
+			payload(p, seq);
+		};
+
+	private:
+		int sock;
+		sockaddr_in addr = {};
+
+		static void put32(std::vector<uint8_t>& p, const uint32_t v){
+			for(int shift = 24; shift >= 0; shift -= 8) p.push_back(v >> shift);
+		};
+
+		void payload(std::vector<uint8_t>& p, const int16_t value){
+			for(size_t i = 0; i < frames; i++){
+				p.push_back(static_cast<uint16_t>(value) >> 8);
+				p.push_back(value);
+			}
+			sendto(sock, p.data(), p.size(), 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+			// keep the arrival order
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		};
+};
+
+// the ingested packets, one sequence number per packet
+std::vector<int16_t> packets(Buffers& buffers){
+	std::lock_guard<std::mutex> lock(buffers.mut);
+	std::vector<int16_t> result;
+	const std::vector<int16_t>& v = buffers.bufs[0].v_buffer;
+	for(size_t i = 0; i < v.size(); i += frames){
+		result.push_back(v[i]);
+	}
+	return result;
+}
+
+bool reports(const Net_Input& input, const std::string& expected){
+	std::ostringstream os;
+	input.report(os);
+	return os.str().find(expected) != std::string::npos;
+}
+
+// wait for the receiver to process the packets and to flush the jitter buffer after the stream stalls
+void settle(){
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+}
+
+int main(){
+	try{
+		const int port = 40000 + getpid() % 20000;
+		Module_Config::Input config;
+		config.port = port;
+		config.f_sample = 1000;
+		// the jitter buffer waits for two packets before it gives up on a missing one
+		config.latency = 2 * frames;
+
+		std::cout << "Invalid port" << std::endl;
+		{
+			Buffers::Ptr buffers = std::make_shared<Buffers>();
+			Net_Input input(buffers);
+			Module_Config::Input invalid = config;
+			invalid.port = 70000;
+			bool thrown = false;
+			try{
+				input.start_stream(invalid);
+			}catch(std::runtime_error&){
+				thrown = true;
+			}
+			if(!thrown) throw std::runtime_error("Invalid port");
+		}
+
+		std::cout << "Loss, reordering and late packets" << std::endl;
+		{
+			Buffers::Ptr buffers = std::make_shared<Buffers>();
+			buffers->bufs.emplace_back(8 * frames);
+			Net_Input input(buffers);
+			config.source = Module_Config::Source::UDP;
+			input.start_stream(config);
+
+			Sender sender(port);
+			// 3 is lost, 4 arrives after 5, the second 4 is a duplicate
+			for(uint32_t seq : {0, 1, 2, 5, 4, 6, 7, 8, 4}){
+				sender.udp(seq);
+			}
+			settle();
+
+			std::vector<int16_t> result = {0, 1, 2, 4, 5, 6, 7, 8};
+			if(packets(*buffers) != result) throw std::runtime_error("Sequence order");
+			if(!reports(input, "9 packets received, 1 lost, 1 reordered, 1 late or duplicate, 0 invalid")){
+				throw std::runtime_error("Loss, reordering and late packets");
+			}
+		}
+
+		std::cout << "Second RTP sender" << std::endl;
+		{
+			Buffers::Ptr buffers = std::make_shared<Buffers>();
+			buffers->bufs.emplace_back(4 * frames);
+			Net_Input input(buffers);
+			config.source = Module_Config::Source::RTP;
+			input.start_stream(config);
+
+			Sender sender(port);
+			// both senders use the same socket, only the SSRC tells them apart
+			for(uint16_t seq = 10; seq < 14; seq++){
+				sender.rtp(seq, 0x1234);
+				sender.rtp(seq + 100, 0x5678);
+			}
+			settle();
+
+			std::vector<int16_t> result = {10, 11, 12, 13};
+			if(packets(*buffers) != result) throw std::runtime_error("Second RTP sender");
+			if(!reports(input, "4 from other senders")) throw std::runtime_error("Second RTP sender");
+
+			std::cout << "Sender change after a stall" << std::endl;
+			for(uint16_t seq = 200; seq < 204; seq++){
+				sender.rtp(seq, 0x5678);
+			}
+			settle();
+
+			result = {200, 201, 202, 203};
+			if(packets(*buffers) != result) throw std::runtime_error("Sender change after a stall");
+		}
+	}
+	catch(std::runtime_error& e){
+		std::cerr << e.what() << " Failed!" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// sender for the network inputs (source = "udp" or "rtp")
+// usage: glmviz_net_sender [--host <ipv4>] [--port <n>] [--rtp] [--l24] [--rate <f_sample>] [--channels <n>]
+//                          [--packet <frames>] [--sine <Hz>] [--loss <p>] [--reorder <p>]
+// sends raw interleaved 16 bit PCM from stdin or a generated sine wave in realtime, e.g.
+//   ffmpeg -re -i song.flac -f s16le -ac 2 -ar 44100 - | glmviz_net_sender --rtp --channels 2
+// --loss and --reorder drop or swap packets with the given probability to test the jitter buffer
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static volatile std::sig_atomic_t running = 1;
+
+static void stop_handler(int){
+	running = 0;
+}
+
+class Sender {
+	public:
+		Sender(const std::string& host, const uint16_t port, const bool rtp, const bool l24, const float loss, const float reorder):
+				rtp(rtp), l24(l24), loss(loss), reorder(reorder), ssrc(std::random_device()()){
+			sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+			if(sock < 0) throw std::runtime_error("Can't create UDP socket: " + std::string(std::strerror(errno)));
+
+			sockaddr_in addr = {};
+			addr.sin_family = AF_INET;
+			addr.sin_port = htons(port);
+			if(inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 || connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0){
+				close(sock);
+				throw std::runtime_error("Can't connect to " + host + ":" + std::to_string(port));
+			}
+		};
+
+		~Sender(){
+			close(sock);
+		};
+
+		// packetize n interleaved frames
+		void send(const int16_t* samples, const size_t n_samples, const size_t n_frames){
+			std::vector<uint8_t> packet;
+			if(rtp){
+				// RFC 3550 header without CSRCs, dynamic payload type
+				put16(packet, 0x8000 | 96);
+				put16(packet, seq);
+			}else{
+				put32(packet, seq);
+			}
+			put32(packet, ts);
+			if(rtp) put32(packet, ssrc);
+
+			for(size_t i = 0; i < n_samples; i++){
+				put16(packet, samples[i]);
+				if(l24) packet.push_back(0);
+			}
+			seq++;
+			ts += n_frames;
+
+			if(random(generator) < loss) return;
+			if(held.empty() && random(generator) < reorder){
+				// send after the next packet
+				held.swap(packet);
+				return;
+			}
+			transmit(packet);
+			if(!held.empty()){
+				transmit(held);
+				held.clear();
+			}
+		};
+
+	private:
+		int sock;
+		bool rtp, l24;
+		float loss, reorder;
+		uint32_t ssrc, seq = 0, ts = 0;
+		std::vector<uint8_t> held;
+		std::minstd_rand generator;
+		std::uniform_real_distribution<float> random{0, 1};
+
+		static void put16(std::vector<uint8_t>& p, const uint16_t v){
+			p.push_back(v >> 8);
+			p.push_back(v);
+		};
+
+		static void put32(std::vector<uint8_t>& p, const uint32_t v){
+			put16(p, v >> 16);
+			put16(p, v);
+		};
+
+		void transmit(const std::vector<uint8_t>& packet){
+			if(::send(sock, packet.data(), packet.size(), 0) < 0 && errno != ECONNREFUSED){
+				std::cerr << "send failed: " << std::strerror(errno) << std::endl;
+			}
+		};
+};
+
+int main(int argc, char* argv[]){
+	std::string host = "127.0.0.1";
+	uint32_t port = 5004, f_sample = 44100, channels = 1, packet = 0;
+	bool rtp = false, l24 = false;
+	float sine = 0, loss = 0, reorder = 0;
+
+	try{
+		for(int i = 1; i < argc; i++){
+			std::string arg = argv[i];
+			if(arg == "--rtp"){
+				rtp = true;
+				continue;
+			}else if(arg == "--l24"){
+				l24 = true;
+				continue;
+			}
+			if(i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+			if(arg == "--host") host = argv[++i];
+			else if(arg == "--port") port = std::stoul(argv[++i]);
+			else if(arg == "--rate") f_sample = std::stoul(argv[++i]);
+			else if(arg == "--channels") channels = std::stoul(argv[++i]);
+			else if(arg == "--packet") packet = std::stoul(argv[++i]);
+			else if(arg == "--sine") sine = std::stof(argv[++i]);
+			else if(arg == "--loss") loss = std::stof(argv[++i]);
+			else if(arg == "--reorder") reorder = std::stof(argv[++i]);
+			else throw std::invalid_argument("Unknown argument: " + arg);
+		}
+		// 5 ms packets by default
+		if(packet == 0) packet = f_sample / 200;
+		if(channels == 0 || f_sample == 0 || port == 0 || port > 65535 || packet * channels * (l24 ? 3 : 2) > 1400){
+			throw std::invalid_argument("Invalid stream format!");
+		}
+	}catch(std::logic_error& e){
+		std::cerr << e.what() << std::endl;
+		std::cerr << "usage: " << argv[0] << " [--host <ipv4>] [--port <n>] [--rtp] [--l24] [--rate <f_sample>] [--channels <n>]"
+		          << " [--packet <frames>] [--sine <Hz>] [--loss <p>] [--reorder <p>]" << std::endl;
+		return 1;
+	}
+
+	std::signal(SIGINT, stop_handler);
+	std::signal(SIGTERM, stop_handler);
+
+	try{
+		Sender sender(host, port, rtp, l24, loss, reorder);
+		std::cerr << "Sending " << (rtp ? "RTP" : "UDP") << (l24 ? " L24" : " L16") << " to " << host << ":" << port
+		          << " (" << f_sample << "Hz, " << channels << " channels)" << std::endl;
+
+		std::vector<int16_t> frames(packet * channels);
+
+		if(sine > 0){
+			auto next = std::chrono::steady_clock::now();
+			const auto period = std::chrono::duration<double>(double(packet) / f_sample);
+			uint64_t t = 0;
+			for(uint64_t n = 1; running; n++){
+				for(size_t i = 0; i < packet; i++, t++){
+					int16_t x = 16000 * std::sin(2 * M_PI * sine * t / f_sample);
+					std::fill_n(frames.begin() + i * channels, channels, x);
+				}
+				sender.send(frames.data(), frames.size(), packet);
+
+				std::this_thread::sleep_until(next + std::chrono::duration_cast<std::chrono::steady_clock::duration>(period * n));
+			}
+		}else{
+			// only send complete packets
+			const size_t size = frames.size() * sizeof(int16_t);
+			char* bytes = reinterpret_cast<char*>(frames.data());
+			size_t pending = 0;
+			while(running){
+				ssize_t n = ::read(STDIN_FILENO, bytes + pending, size - pending);
+				if(n < 0 && errno == EINTR) continue;
+				if(n <= 0) break;
+
+				pending += n;
+				if(pending == size){
+					sender.send(frames.data(), frames.size(), packet);
+					pending = 0;
+				}
+			}
+		}
+	}catch(std::runtime_error& e){
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ *	Copyright (C) 2018  Hannes Haberl
+ *
+ *	This file is part of GLMViz.
+ *
+ *	GLMViz is free software: you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or
+ *	(at your option) any later version.
+ *
+ *	GLMViz is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with GLMViz.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// reference producer for the shared memory ring input (source = "shm")
+// usage: glmviz_shm_producer [--name <shm name>] [--rate <f_sample>] [--channels <n>] [--capacity <frames>] [--sine <Hz>]
+// publishes raw interleaved 16 bit PCM from stdin as it arrives, or a generated sine wave in realtime, e.g.
+//   ffmpeg -re -i song.flac -f s16le -ac 2 -ar 44100 - | glmviz_shm_producer --channels 2
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Shm_Ring.hpp"
+
+static volatile std::sig_atomic_t running = 1;
+
+static void stop_handler(int){
+	running = 0;
+}
+
+class Producer {
+	public:
+		Producer(const std::string& n, const uint32_t f_sample, const uint32_t channels, const uint32_t capacity): name(n){
+			int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+			if(fd < 0) throw std::runtime_error("Can't create shared memory " + name + ": " + std::strerror(errno));
+
+			size = Shm_Ring::size(capacity, channels);
+			if(ftruncate(fd, size) < 0){
+				close(fd);
+				throw std::runtime_error("Can't resize shared memory: " + std::string(std::strerror(errno)));
+			}
+			void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			close(fd);
+			if(map == MAP_FAILED) throw std::runtime_error("Can't map shared memory: " + std::string(std::strerror(errno)));
+
+			ring = reinterpret_cast<Shm_Ring::Header*>(map);
+			ring->magic = 0;
+			ring->version = Shm_Ring::VERSION;
+			ring->format = Shm_Ring::FORMAT_S16;
+			ring->f_sample = f_sample;
+			ring->channels = channels;
+			ring->capacity = capacity;
+			ring->write_index = 0;
+			ring->sequence = 0;
+			ring->waiting = 0;
+			// publish the initialized header
+			ring->magic.store(Shm_Ring::MAGIC, std::memory_order_release);
+		};
+
+		~Producer(){
+			munmap(ring, size);
+			shm_unlink(name.c_str());
+		};
+
+		// copy n interleaved frames into the ring and wake up the reader
+		void publish(const int16_t* frames, const uint64_t n){
+			const uint64_t capacity = ring->capacity, channels = ring->channels;
+			uint64_t index = ring->write_index.load(std::memory_order_relaxed);
+			for(uint64_t i = 0; i < n;){
+				uint64_t start = (index + i) % capacity;
+				uint64_t count = std::min(n - i, capacity - start);
+				std::memcpy(Shm_Ring::samples(ring) + start * channels, frames + i * channels, count * channels * sizeof(int16_t));
+				i += count;
+			}
+			ring->write_index.store(index + n, std::memory_order_release);
+			ring->sequence++;
+			if(ring->waiting) Shm_Ring::wake(ring);
+		};
+
+	private:
+		std::string name;
+		size_t size;
+		Shm_Ring::Header* ring;
+};
+
+int main(int argc, char* argv[]){
+	std::string name = "/glmviz";
+	uint32_t f_sample = 44100, channels = 1, capacity = 1 << 14;
+	float sine = 0;
+
+	try{
+		for(int i = 1; i < argc; i++){
+			std::string arg = argv[i];
+			if(i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+			if(arg == "--name") name = argv[++i];
+			else if(arg == "--rate") f_sample = std::stoul(argv[++i]);
+			else if(arg == "--channels") channels = std::stoul(argv[++i]);
+			else if(arg == "--capacity") capacity = std::stoul(argv[++i]);
+			else if(arg == "--sine") sine = std::stof(argv[++i]);
+			else throw std::invalid_argument("Unknown argument: " + arg);
+		}
+		if(channels == 0 || capacity == 0 || f_sample == 0) throw std::invalid_argument("Invalid ring format!");
+	}catch(std::logic_error& e){
+		std::cerr << e.what() << std::endl;
+		std::cerr << "usage: " << argv[0] << " [--name <shm name>] [--rate <f_sample>] [--channels <n>] [--capacity <frames>] [--sine <Hz>]" << std::endl;
+		return 1;
+	}
+
+	std::signal(SIGINT, stop_handler);
+	std::signal(SIGTERM, stop_handler);
+
+	try{
+		Producer producer(name, f_sample, channels, capacity);
+		std::cerr << "Publishing to " << name << " (" << f_sample << "Hz, " << channels << " channels)" << std::endl;
+
+		// 5 ms blocks
+		const size_t block = f_sample / 200;
+		std::vector<int16_t> frames(block * channels);
+
+		if(sine > 0){
+			auto next = std::chrono::steady_clock::now();
+			uint64_t t = 0;
+			while(running){
+				for(size_t i = 0; i < block; i++, t++){
+					int16_t x = 16000 * std::sin(2 * M_PI * sine * t / f_sample);
+					std::fill_n(frames.begin() + i * channels, channels, x);
+				}
+				producer.publish(frames.data(), block);
+
+				next += std::chrono::microseconds(5000);
+				std::this_thread::sleep_until(next);
+			}
+		}else{
+			const size_t frame_size = channels * sizeof(int16_t);
+			char* bytes = reinterpret_cast<char*>(frames.data());
+			size_t pending = 0;
+			while(running){
+				ssize_t n = ::read(STDIN_FILENO, bytes + pending, frames.size() * sizeof(int16_t) - pending);
+				if(n < 0 && errno == EINTR) continue;
+				if(n <= 0) break;
+
+				// only publish complete frames
+				size_t length = pending + n;
+				producer.publish(frames.data(), length / frame_size);
+				pending = length % frame_size;
+				std::memmove(bytes, bytes + length - pending, pending);
+			}
+		}
+	}catch(std::runtime_error& e){
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -20,6 +20,8 @@
 #include "xdg.hpp"
 
 #include <pwd.h>
+#include <sys/stat.h>
+#include <cerrno>
 #include <unistd.h>
 #include <fstream>
 #include <sstream>
@@ -94,4 +96,48 @@ namespace xdg{
 		// return empty string if no config file was found
 		return "";
 	}
+
+	std::string cache_home(){
+		std::string cache_home;
+		const char* cxdg_cache_home = std::getenv("XDG_CACHE_HOME");
+		if(cxdg_cache_home != nullptr){
+			cache_home = cxdg_cache_home;
+		}
+
+		return cache_home;
+	}
+
+	std::string default_cache_home(){
+		std::string cache_home;
+		// get default cache directory
+		struct passwd* pw = ::getpwuid(::getuid());
+		cache_home = pw->pw_dir;
+		cache_home += "/.cache";
+
+		return cache_home;
+	}
+
+	// create all missing directories of the given path
+	bool make_path(const std::string& path){
+		size_t pos = 0;
+		do{
+			pos = path.find('/', pos + 1);
+			std::string dir = path.substr(0, pos);
+			if(::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST){
+				return false;
+			}
+		}while(pos != std::string::npos);
+
+		return true;
+	}
+
+	std::string cache_dir(const std::string& path){
+		std::string cache = cache_home();
+		if(cache.empty()) cache = default_cache_home();
+
+		cache += path;
+		if(!make_path(cache)) return "";
+
+		return cache;
+	}
 }
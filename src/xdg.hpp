@@ -30,4 +30,10 @@ namespace xdg{
 	bool verify_path(const std::string&);
 
 	std::string find_config(const std::string&);
+
+	std::string cache_home();
+	std::string default_cache_home();
+	bool make_path(const std::string&);
+
+	std::string cache_dir(const std::string&);
 }